@@ -0,0 +1,114 @@
+// Adaptive Huffman coding header
+
+#ifndef HUFFMANADAPTIVE_H
+#define HUFFMANADAPTIVE_H
+
+#include "huffmanarena.h"
+#include "huffmancodetable.h"
+#include "huffmandecoder.h"
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+namespace YNGMAT005 {
+
+	// Bytes read from an input stream and encoded as one chunk
+	const std::size_t ADAPTIVE_CHUNK_SIZE = std::size_t(1) << 16;
+
+	// Bytes coded between table rebuilds unless told otherwise
+	const std::size_t ADAPTIVE_REBUILD_INTERVAL = std::size_t(1) << 16;
+
+	// Counts are halved once their total passes this, so the model follows
+	// recent data and its counts stay bounded on unbounded streams
+	const uint64_t ADAPTIVE_COUNT_LIMIT = uint64_t(1) << 16;
+
+	// Byte counts seen so far and the code table built from them. Every
+	// byte value starts with a count of 1, so any byte can be coded from
+	// the first chunk on. Encoder and decoder feed their models the same
+	// bytes in the same chunks, so they rebuild identical tables at
+	// identical points without any table being sent.
+	class AdaptiveModel {
+		private:
+			uint64_t counts[256];
+			uint64_t total;
+			std::size_t interval;
+			std::size_t since_rebuild;
+			HuffmanArena arena;
+			HuffmanCodeTable codes;
+
+			void rebuild(void);
+
+		public:
+			// rebuild the table every 'interval' bytes (0 for ADAPTIVE_REBUILD_INTERVAL)
+			AdaptiveModel(std::size_t interval);
+
+			// go back to the starting counts and table
+			void reset(void);
+			// as above, rebuilding every 'interval' bytes from now on
+			void reset(std::size_t interval);
+			// count a chunk of bytes once it has been coded; true if the table was rebuilt
+			bool update(const unsigned char* data, std::size_t size);
+			const HuffmanCodeTable & get_codes(void) const;
+			std::size_t get_interval(void) const;
+	};
+
+	// Encodes a stream chunk by chunk with codes from the bytes before it.
+	// The stream starts with the rebuild interval (varint), each chunk is
+	// framed as
+	//   raw size (varint) | packed size (varint) | packed bits
+	// and a raw size of 0 ends the stream.
+	class AdaptiveEncoder {
+		private:
+			AdaptiveModel model;
+			unsigned longest;
+			std::size_t chunk_size;
+			bool started;
+
+			// append the rebuild interval to 'out' ahead of the first frame
+			void start(std::vector<unsigned char> & out);
+
+		public:
+			AdaptiveEncoder(std::size_t interval);
+
+			// start a new stream
+			void reset(void);
+			// append the frame of a chunk of data[0, size) to 'out' (nothing for an empty chunk)
+			void encode(const unsigned char* data, std::size_t size, std::vector<unsigned char> & out);
+			// append the end of stream marker to 'out'
+			void finish(std::vector<unsigned char> & out);
+			// encode 'in' to 'out' ADAPTIVE_CHUNK_SIZE bytes at a time, or a rebuild
+			// interval at a time if that is shorter, writing each frame as soon as it is encoded
+			bool compress(std::istream & in, std::ostream & out);
+	};
+
+	// Decodes streams written by AdaptiveEncoder, taking the rebuild interval
+	// from the start of the stream
+	class AdaptiveDecoder {
+		private:
+			AdaptiveModel model;
+			HuffmanDecoder decoder;
+			std::vector<unsigned char> packed;
+			bool started;
+
+			// append a varint from 'in' to 'packed', a byte at a time so nothing past it is read
+			bool read_field(std::istream & in, uint64_t & value);
+
+		public:
+			AdaptiveDecoder(void);
+
+			// start a new stream
+			void reset(void);
+			// decode the frame at the start of data[0, size) into 'out', setting
+			// 'used' to its length, and the rebuild interval before it if it is the
+			// first; 'finished' is set at the end of stream marker
+			bool decode(const unsigned char* data, std::size_t size, std::size_t & used, std::vector<unsigned char> & out,
+				bool & finished);
+			// decode frames from 'in' to 'out' until the end of stream marker
+			bool decompress(std::istream & in, std::ostream & out);
+	};
+
+}
+
+#endif
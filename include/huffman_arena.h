@@ -0,0 +1,72 @@
+// Huffman Arena class header
+
+#ifndef HUFFMANARENA_H
+#define HUFFMANARENA_H
+
+#include "huffmannode.h"
+#include "huffmancodetable.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace YNGMAT005 {
+
+	// Index used for a missing child or an empty tree
+	const uint32_t NO_NODE = 0xFFFFFFFF;
+
+	// Most nodes a tree over byte values can have
+	const uint32_t MAX_ARENA_NODES = 2 * 256 - 1;
+
+	// A tree node addressed by its index in the arena
+	struct ArenaNode {
+		uint64_t frequency;
+		uint32_t left;
+		uint32_t right;
+		uint16_t letter;
+	};
+
+	// Huffman tree stored as one contiguous vector of nodes linked by
+	// 32-bit indices, so building and walking it never allocates per node
+	class HuffmanArena {
+		private:
+			std::vector<ArenaNode> nodes;
+			uint32_t root;
+
+			// rebuild leaves[first, last), sorted left-aligned codes sharing their
+			// first 'depth' bits, as a subtree and return its index
+			uint32_t add_canonical(const HuffmanCodeTable & codes, const uint64_t* frequencies,
+				const uint64_t* leaves, const unsigned char* letters, uint32_t first, uint32_t last, unsigned depth);
+
+		public:
+			HuffmanArena(void);
+
+			void clear(void);
+			uint32_t add_leaf(unsigned char letter, uint64_t frequency);
+			uint32_t add_parent(uint32_t left, uint32_t right);
+
+			// build a Huffman tree from the frequencies of the 256 byte values in
+			// linear time after one sort (two-queue construction)
+			void build(const uint64_t* frequencies);
+			// replace the tree with one whose paths spell out the given codes
+			void build_canonical(const HuffmanCodeTable & codes, const uint64_t* frequencies);
+			// write each leaf's depth as its code length (a lone leaf gets 1)
+			void code_lengths(unsigned char* lengths) const;
+			// copy the subtree at 'index' into linked HuffmanNodes
+			std::shared_ptr<HuffmanNode> to_nodes(uint32_t index) const;
+
+			const ArenaNode & get(uint32_t index) const {
+				return nodes[index];
+			}
+
+			bool is_leaf(uint32_t index) const {
+				return nodes[index].left == NO_NODE && nodes[index].right == NO_NODE;
+			}
+
+			uint32_t get_root(void) const;
+			std::size_t size(void) const;
+			bool empty(void) const;
+	};
+
+}
+
+#endif
@@ -0,0 +1,247 @@
+// Bit stream reader and writer header
+
+#ifndef HUFFMANBITS_H
+#define HUFFMANBITS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <vector>
+
+namespace YNGMAT005 {
+
+	// Longest code the bit buffers can hold after a single refill
+	const unsigned MAX_CODE_LENGTH = 56;
+
+	// Bytes a streaming bit reader pulls from its input at a time
+	const std::size_t STREAM_CHUNK_SIZE = 1 << 16;
+
+	// true if 'symbols' symbols can be coded in exactly 'bits' bits, every code
+	// being 1 to MAX_CODE_LENGTH bits long; a size read from untrusted input is
+	// only used to allocate once it passes this against the bits behind it
+	inline bool fits_code_lengths(uint64_t symbols, uint64_t bits) {
+		return symbols <= bits && bits / MAX_CODE_LENGTH + (bits % MAX_CODE_LENGTH != 0) <= symbols;
+	}
+
+	// as above when only the packed size is known: 'bytes' bytes, the last
+	// padded with zeros, hold anywhere from 8 * bytes - 7 to 8 * bytes bits
+	inline bool fits_packed_bytes(uint64_t symbols, uint64_t bytes) {
+		if(bytes == 0 || bytes >> 58 != 0) {
+			return bytes == 0 && symbols == 0;
+		}
+		uint64_t fewest_bits = bytes * 8 - 7;
+		return symbols <= bytes * 8 && (fewest_bits + MAX_CODE_LENGTH - 1) / MAX_CODE_LENGTH <= symbols;
+	}
+
+	// append 'value' to 'out' as 'bytes' little-endian bytes
+	inline void put_le(std::vector<unsigned char> & out, uint64_t value, unsigned bytes) {
+		for(unsigned i = 0; i < bytes; i++) {
+			out.push_back((unsigned char)(value >> (8 * i)));
+		}
+	}
+
+	// read a 'bytes' byte little-endian value
+	inline uint64_t get_le(const unsigned char* data, unsigned bytes) {
+		uint64_t value = 0;
+		for(unsigned i = 0; i < bytes; i++) {
+			value |= uint64_t(data[i]) << (8 * i);
+		}
+		return value;
+	}
+
+	// append 'value' to 'out' seven bits at a time, low bits first, with the
+	// top bit of each byte set while more follow
+	inline void put_varint(std::vector<unsigned char> & out, uint64_t value) {
+		while(value >= 0x80) {
+			out.push_back((unsigned char)(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back((unsigned char)value);
+	}
+
+	// read a value written by put_varint from data[0, size); 'used' is set to
+	// the number of bytes read. False if it runs off the end or past 64 bits.
+	inline bool get_varint(const unsigned char* data, std::size_t size, uint64_t & value, std::size_t & used) {
+		value = 0;
+		for(std::size_t i = 0; i < size && i < 10; i++) {
+			value |= uint64_t(data[i] & 0x7F) << (7 * i);
+			if((data[i] & 0x80) == 0) {
+				used = i + 1;
+				return i < 9 || data[i] <= 1;
+			}
+		}
+		return false;
+	}
+
+	// Reads an MSB-first bit stream from a byte buffer, or in chunks from an
+	// input stream, through a 64-bit register. Bits are left-aligned in the
+	// register so that the next code can be peeked with a single shift.
+	class BitReader {
+		private:
+			const unsigned char* pos;
+			const unsigned char* end;
+			uint64_t buffer;
+			unsigned count;
+			uint64_t bits_read;
+			std::istream* in;
+			std::vector<unsigned char> chunk;
+
+			// move the unread tail of the chunk to its front and fill the rest from the stream
+			void load(void) {
+				std::size_t left = end - pos;
+				for(std::size_t i = 0; i < left; i++) {
+					chunk[i] = pos[i];
+				}
+				in->read((char*)&chunk[left], chunk.size() - left);
+				std::size_t read = in->gcount();
+				if(read == 0) {
+					in = nullptr;
+				}
+				pos = chunk.data();
+				end = chunk.data() + left + read;
+			}
+
+		public:
+			BitReader(const unsigned char* data, std::size_t size) {
+				pos = data;
+				end = data + size;
+				buffer = 0;
+				count = 0;
+				bits_read = 0;
+				in = nullptr;
+			}
+
+			// read from the current position of 'stream' until it runs out
+			BitReader(std::istream & stream) : chunk(STREAM_CHUNK_SIZE) {
+				pos = chunk.data();
+				end = chunk.data();
+				buffer = 0;
+				count = 0;
+				bits_read = 0;
+				in = &stream;
+			}
+
+			// top up the register to at least MAX_CODE_LENGTH bits, reading
+			// zeros once the input runs out
+			void refill(void) {
+				if(end - pos < 8 && in != nullptr) {
+					this->load();
+				}
+				if(end - pos >= 8) {
+					uint64_t word = 0;
+					for(int i = 0; i < 8; i++) {
+						word = (word << 8) | pos[i];
+					}
+					buffer |= word >> count;
+					pos += (63 - count) >> 3;
+					count |= 56;
+				} else {
+					while(count < 56) {
+						uint64_t byte = pos < end ? *pos++ : 0;
+						buffer |= byte << (56 - count);
+						count += 8;
+					}
+				}
+			}
+
+			// look at the next n bits (1 <= n <= MAX_CODE_LENGTH) without consuming them
+			uint64_t peek(unsigned n) const {
+				return buffer >> (64 - n);
+			}
+
+			// look at n bits starting offset bits into the register
+			uint64_t peek(unsigned offset, unsigned n) const {
+				return (buffer << offset) >> (64 - n);
+			}
+
+			void consume(unsigned n) {
+				buffer <<= n;
+				count -= n;
+				bits_read += n;
+			}
+
+			// number of bits currently held in the register
+			unsigned available(void) const {
+				return count;
+			}
+
+			// total number of bits consumed so far
+			uint64_t consumed(void) const {
+				return bits_read;
+			}
+	};
+
+	// Writes an MSB-first bit stream into a byte buffer. Codes are gathered
+	// in a 64-bit register and whole bytes are stored a word at a time.
+	class BitWriter {
+		private:
+			unsigned char* start;
+			unsigned char* pos;
+			unsigned char* end;
+			uint64_t buffer;
+			unsigned count;
+			uint64_t bits_written;
+
+		public:
+			BitWriter(unsigned char* data, std::size_t size) {
+				start = data;
+				pos = data;
+				end = data + size;
+				buffer = 0;
+				count = 0;
+				bits_written = 0;
+			}
+
+			// append the low 'length' bits of 'bits' (1 <= length <= MAX_CODE_LENGTH)
+			void write(uint64_t bits, unsigned length) {
+				buffer |= bits << (64 - count - length);
+				count += length;
+				bits_written += length;
+
+				unsigned full = count >> 3;
+				if(end - pos >= 8) {
+					// store the whole register and keep only the full bytes
+					for(int i = 0; i < 8; i++) {
+						pos[i] = (unsigned char)(buffer >> (56 - 8 * i));
+					}
+					pos += full;
+					buffer <<= 8 * full;
+					count &= 7;
+				} else {
+					for(unsigned i = 0; i < full && pos < end; i++) {
+						*pos++ = (unsigned char)(buffer >> 56);
+						buffer <<= 8;
+					}
+					count &= 7;
+				}
+			}
+
+			// write out the last partial byte, padded with zeros
+			void flush(void) {
+				if(count > 0 && pos < end) {
+					*pos++ = (unsigned char)(buffer >> 56);
+				}
+				buffer = 0;
+				count = 0;
+			}
+
+			// total number of bits written so far
+			uint64_t written(void) const {
+				return bits_written;
+			}
+
+			// number of whole bytes stored in the buffer
+			std::size_t bytes(void) const {
+				return pos - start;
+			}
+
+			// start storing at the front of the buffer again once its bytes have
+			// been handed on, keeping any bits not yet making up a whole byte
+			void restart(void) {
+				pos = start;
+			}
+	};
+
+}
+
+#endif
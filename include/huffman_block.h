@@ -0,0 +1,178 @@
+// Block container header
+
+#ifndef HUFFMANBLOCK_H
+#define HUFFMANBLOCK_H
+
+#include "huffmanarena.h"
+#include "huffmancodetable.h"
+#include "huffmandecoder.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+namespace YNGMAT005 {
+
+	// Marks the start of a block container
+	const unsigned char BLOCK_MAGIC[4] = { 'H', 'U', 'F', 'B' };
+	const unsigned char BLOCK_VERSION = 4;
+
+	// Marks the footer that locates the block table
+	const unsigned char TABLE_MAGIC[4] = { 'H', 'U', 'F', 'T' };
+	// block count (8 bytes) | table offset (8 bytes) | checkpoint interval (8 bytes) | table magic
+	const std::size_t FOOTER_SIZE = 28;
+	// compressed offset (8 bytes) | raw size (8 bytes) | checkpoints offset (8 bytes)
+	const std::size_t TABLE_ENTRY_SIZE = 24;
+
+	// Raw bytes between checkpoints unless told otherwise
+	const std::size_t DEFAULT_CHECKPOINT_INTERVAL = std::size_t(1) << 16;
+
+	// Input bytes per block unless told otherwise
+	const std::size_t DEFAULT_BLOCK_SIZE = std::size_t(1) << 20;
+
+	// Fixed part of a block before its code lengths
+	const std::size_t BLOCK_FIELDS_SIZE = 16;
+
+	// Everything needed to decode a block's packed bits
+	struct BlockHeader {
+		uint64_t raw_size;
+		uint64_t bit_count;
+		HuffmanCodeTable codes;
+		// number of interleaved bit streams, and the bits in each
+		unsigned streams;
+		uint64_t stream_bits[DECODE_STREAMS];
+		// bytes taken by the fields and code lengths, and by the packed bits
+		std::size_t header_size;
+		uint64_t payload_size;
+	};
+
+	// Where a block sits in the container and in the decompressed output, and
+	// where its checkpoints are kept
+	struct BlockEntry {
+		uint64_t offset;
+		uint64_t raw_offset;
+		uint64_t raw_size;
+		uint64_t checkpoints;
+		// raw bytes between checkpoints (0 if the container has none)
+		uint64_t interval;
+	};
+
+	// Writes a container around blocks encoded elsewhere: the magic and
+	// version up front, each block as it is handed over in order, and the
+	// table, checkpoints and footer at the end
+	class BlockWriter {
+		private:
+			std::ostream & out;
+			uint64_t offset;
+			uint64_t interval;
+			std::vector<BlockEntry> table;
+			std::vector<unsigned char> index;
+
+		public:
+			// start a container on 'out' whose blocks have checkpoints every 'interval' bytes
+			BlockWriter(std::ostream & out, std::size_t interval);
+
+			// write the next block's frame, with the stream bit offsets at its checkpoints
+			void write(const std::vector<unsigned char> & frame, uint64_t raw_size, const std::vector<uint64_t> & checkpoints);
+			// end the blocks and write the table and footer
+			bool finish(void);
+	};
+
+	// Each block is encoded on its own, with its own code table:
+	//   raw size (8 bytes) | bit count (8 bytes) | code lengths |
+	//   stream count (1 byte) | bit counts of all but the last stream (8 bytes each) |
+	//   packed bits of each stream, each starting on a byte boundary
+	// With several streams, byte i of the block is coded into stream i % streams.
+	// A container is the magic and version, the blocks in order, a raw size of 0
+	// to end them, then a table of every block's offset and raw size, and a
+	// fixed-size footer pointing at the table so blocks can be found without
+	// reading through the ones before them.
+	// Every 'interval' raw bytes into a block a checkpoint records the bit offset
+	// of each of its streams, so decoding can start there instead of at the
+	// start of the block. A block's checkpoints follow the table as
+	// (raw size - 1) / interval groups of one 8-byte bit offset per stream.
+	class BlockCompressor {
+		private:
+			std::size_t block_size;
+			unsigned threads;
+			unsigned max_code_length;
+			unsigned streams;
+			std::size_t checkpoint_interval;
+
+			// encode the blocks handed out by 'next' and write the container to 'out';
+			// 'next' sets the block's bytes, and the buffer holding them if they
+			// were copied in, and returns false once there are none left.
+			// Reading, encoding and writing run at the same time: a reader thread
+			// calls 'next' and queues the blocks, a thread per encoder takes them
+			// off the queue and queues the frames, and the calling thread writes
+			// the frames out in order. Lock-free queues sit between the stages,
+			// and at most two blocks per encoder are between reading and writing.
+			// A stage with nothing to do yields briefly and then sleeps.
+			bool write_container(std::function<bool(const unsigned char* &, std::size_t &,
+				std::shared_ptr<std::vector<unsigned char>> &)> next, std::ostream & out) const;
+
+		public:
+			// 'threads' encode blocks concurrently (0 for one per hardware thread)
+			BlockCompressor(std::size_t block_size, unsigned threads);
+
+			// limit code lengths to 'length' bits (0 for no limit beyond MAX_CODE_LENGTH)
+			void set_max_code_length(unsigned length);
+			// split each block into 1 or DECODE_STREAMS interleaved streams (DECODE_STREAMS by default)
+			bool set_streams(unsigned streams);
+			// record a checkpoint every 'interval' raw bytes (0 for none), rounded
+			// up to a multiple of DECODE_STREAMS; DEFAULT_CHECKPOINT_INTERVAL by default
+			void set_checkpoint_interval(std::size_t interval);
+
+			// build a tree for data[0, size) alone and append its encoded block to 'frame'
+			void encode_block(const unsigned char* data, std::size_t size, std::vector<unsigned char> & frame) const;
+			// as above, also setting 'checkpoints' to the stream bit offsets at each checkpoint
+			void encode_block(const unsigned char* data, std::size_t size, std::vector<unsigned char> & frame,
+				std::vector<uint64_t> & checkpoints) const;
+			// as above, building the tree in 'arena' so its memory can be reused
+			void encode_block(const unsigned char* data, std::size_t size, std::vector<unsigned char> & frame,
+				std::vector<uint64_t> & checkpoints, HuffmanArena & arena) const;
+			// read 'in' a block at a time, encode the blocks on 'threads' threads and
+			// write them to 'out' in order
+			bool compress(std::istream & in, std::ostream & out) const;
+			// as above, encoding the blocks in place from data[0, size)
+			bool compress(const unsigned char* data, std::size_t size, std::ostream & out) const;
+	};
+
+	// Reads containers written by BlockCompressor
+	class BlockDecompressor {
+		private:
+			unsigned threads;
+
+		public:
+			BlockDecompressor(void);
+			// decode blocks of in-memory containers on 'threads' threads (0 for one per hardware thread)
+			BlockDecompressor(unsigned threads);
+
+			// parse the block header at the start of data[0, size)
+			static bool read_header(const unsigned char* data, std::size_t size, BlockHeader & header);
+			// decode a block's packed bits into out[0, raw size)
+			static bool decode_block(const BlockHeader & header, const unsigned char* payload, unsigned char* out);
+			// as above, building the tables in 'decoder' so its memory can be reused
+			static bool decode_block(const BlockHeader & header, const unsigned char* payload, unsigned char* out,
+				HuffmanDecoder & decoder);
+			// read the block table of the container in data[0, size)
+			static bool read_table(const unsigned char* data, std::size_t size, std::vector<BlockEntry> & table);
+
+			// decode a whole container from 'in' to 'out', one block after another
+			bool decompress(std::istream & in, std::ostream & out) const;
+			// decode the container in data[0, size) into 'out', with the blocks spread
+			// over a thread pool and each written straight to its place in 'out'
+			bool decompress(const unsigned char* data, std::size_t size, std::vector<unsigned char> & out) const;
+			// decode only raw bytes [offset, offset + length) of the container in
+			// data[0, size) into 'out', starting each block at the checkpoint
+			// nearest before the range
+			static bool decode_range(const unsigned char* data, std::size_t size, uint64_t offset, uint64_t length,
+				std::vector<unsigned char> & out);
+	};
+
+}
+
+#endif
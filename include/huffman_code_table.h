@@ -0,0 +1,64 @@
+// Huffman Code Table class header
+
+#ifndef HUFFMANCODETABLE_H
+#define HUFFMANCODETABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace YNGMAT005 {
+
+	// A letter's code as an integer: the low 'length' bits of 'bits',
+	// most significant bit first
+	struct HuffmanCode {
+		uint64_t bits;
+		unsigned char length;
+	};
+
+	// Codes for every byte value, indexed directly by the byte. Canonical
+	// tables are fully described by their code lengths, which is all that
+	// gets serialized.
+	class HuffmanCodeTable {
+		private:
+			HuffmanCode codes[256];
+
+		public:
+			HuffmanCodeTable(void);
+
+			void clear(void);
+			void set(unsigned char letter, uint64_t bits, unsigned char length);
+			// assign canonical codes from per-letter code lengths (0 = unused):
+			// shorter codes first, and letters in byte order within a length
+			bool assign_canonical(const unsigned char* lengths);
+			// compute optimal code lengths no longer than 'max_length' from letter
+			// frequencies (package-merge) and assign canonical codes from them
+			bool build_limited(const uint64_t* frequencies, unsigned max_length);
+			// assign canonical codes from a tree's code lengths, or if any is longer
+			// than 'max_length' (0 for no limit beyond MAX_CODE_LENGTH), from
+			// length-limited ones computed from the letter frequencies
+			bool build(const unsigned char* lengths, const uint64_t* frequencies, unsigned max_length);
+			// append the code lengths of the used letters to 'out'
+			void serialize(std::vector<unsigned char> & out) const;
+			// read code lengths written by serialize and assign canonical codes;
+			// 'used' is set to the number of bytes read
+			bool deserialize(const unsigned char* data, std::size_t size, std::size_t & used);
+			// number of letters with a code
+			unsigned size(void) const;
+			// the letter's code as a string of '0' and '1' characters
+			std::string bit_string(unsigned char letter) const;
+
+			const HuffmanCode & get(unsigned char letter) const {
+				return codes[letter];
+			}
+
+			// true if the letter has a code
+			bool contains(unsigned char letter) const {
+				return codes[letter].length != 0;
+			}
+	};
+
+}
+
+#endif
@@ -0,0 +1,51 @@
+// Huffman Codec class header
+
+#ifndef HUFFMANCODEC_H
+#define HUFFMANCODEC_H
+
+#include "huffmanarena.h"
+#include "huffmandecoder.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace YNGMAT005 {
+
+	// Inputs smaller than this are coded as one stream; the extra stream
+	// sizes and padding of interleaved streams only pay off on larger ones
+	const std::size_t INTERLEAVE_MIN_SIZE = std::size_t(1) << 14;
+
+	// Compresses buffers in memory, without touching the filesystem. A
+	// compressed buffer is a single block as written by BlockCompressor:
+	//   raw size (8 bytes) | bit count (8 bytes) | code lengths | streams | packed bits
+	// or just a raw size of 0 for an empty input.
+	// A codec is a reusable context: the tree, the decode tables and any
+	// output vector handed back to it keep their memory between messages,
+	// so once they have grown to the largest message no more is allocated.
+	class HuffmanCodec {
+		private:
+			unsigned max_code_length;
+			HuffmanArena arena;
+			HuffmanDecoder decoder;
+			std::vector<uint64_t> checkpoints;
+
+		public:
+			HuffmanCodec(void);
+
+			// limit code lengths to 'length' bits (0 for no limit beyond MAX_CODE_LENGTH)
+			void set_max_code_length(unsigned length);
+			// drop the last message's tree and tables, keeping their memory
+			void reset(void);
+
+			// compress data[0, size) with a code built for it alone
+			std::vector<unsigned char> compress(const unsigned char* data, std::size_t size);
+			// as above, replacing the contents of 'out' and reusing its capacity
+			void compress(const unsigned char* data, std::size_t size, std::vector<unsigned char> & out);
+			// decompress a buffer written by compress into 'out', reusing its
+			// capacity; false if it is truncated, has trailing bytes or doesn't decode
+			bool decompress(const unsigned char* data, std::size_t size, std::vector<unsigned char> & out);
+	};
+
+}
+
+#endif
@@ -0,0 +1,103 @@
+// Huffman Decoder class header
+
+#ifndef HUFFMANDECODER_H
+#define HUFFMANDECODER_H
+
+#include "huffmanbits.h"
+#include "huffmancodetable.h"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace YNGMAT005 {
+
+	// Number of bits resolved by the primary lookup table
+	const unsigned DECODE_TABLE_BITS = 11;
+
+	// Number of interleaved bit streams a block can be split into
+	const unsigned DECODE_STREAMS = 4;
+
+	// Symbols decoded into a local buffer before they are handed to a string or stream
+	const std::size_t DECODE_BUFFER_SIZE = 1 << 16;
+
+	// One slot of a lookup table. Leaves carry the symbol and the full code
+	// length; links (length 0) point to a subtable indexed by the next
+	// 'bits' bits of the stream. A slot with neither is an invalid code.
+	struct DecodeEntry {
+		uint16_t symbol;
+		uint8_t length;
+		uint8_t bits;
+		uint32_t next;
+	};
+
+	// Table-driven Huffman decoder: one table hit per symbol for codes that
+	// fit in the primary table, and a chain of subtables for longer codes
+	class HuffmanDecoder {
+		private:
+			std::vector<DecodeEntry> table;
+			unsigned root_bits;
+			unsigned max_length;
+			// codes sorted by prefix while building, kept to reuse their memory
+			std::vector<std::pair<uint64_t, uint16_t>> sorted;
+
+			// fill the table at 'base' of width 'bits' with codes[first, last),
+			// all of which share their leading 'depth' bits; false if they overlap
+			bool fill(uint32_t base, unsigned bits, unsigned depth, std::vector<std::pair<uint64_t, uint16_t>> & codes,
+				const unsigned char* lengths, std::size_t first, std::size_t last);
+
+			// decode one symbol from the register, which must hold at least
+			// max_length bits; -1 for an invalid code
+			int next_symbol(BitReader & reader) const {
+				const DecodeEntry* entry = &table[reader.peek(root_bits)];
+				unsigned offset = root_bits;
+
+				// follow subtable links for codes longer than the primary table
+				while(entry->length == 0) {
+					if(entry->bits == 0) {
+						return -1;
+					}
+					const DecodeEntry* next = &table[entry->next + reader.peek(offset, entry->bits)];
+					offset += entry->bits;
+					entry = next;
+				}
+
+				reader.consume(entry->length);
+				return entry->symbol;
+			}
+
+		public:
+			HuffmanDecoder(void);
+
+			// build the lookup tables from per-symbol codes and code lengths
+			// (a length of 0 means the symbol is unused)
+			bool build(const uint64_t* codes, const unsigned char* lengths, unsigned num_symbols);
+			// build the lookup tables for the codes of a code table
+			bool build(const HuffmanCodeTable & codes);
+			// forget the codes, keeping the tables' memory for the next build
+			void clear(void);
+			// decode symbols into out[0, capacity) until the buffer is full or
+			// 'bit_count' bits have been consumed; 'written' is set to the number
+			// of symbols decoded. False if the stream holds an invalid code.
+			bool decode(BitReader & reader, uint64_t bit_count, unsigned char* out, std::size_t capacity,
+				std::size_t & written) const;
+			// decode symbols until 'bit_count' bits have been consumed
+			bool decode(BitReader & reader, uint64_t bit_count, std::string & out) const;
+			// as above, writing the symbols to 'out' through a fixed-size buffer
+			bool decode(BitReader & reader, uint64_t bit_count, std::ostream & out) const;
+			// decode 'size' symbols from DECODE_STREAMS readers, symbol i coming from
+			// stream i % DECODE_STREAMS, working on every stream in each pass so
+			// the lookups don't wait on one another. False on an invalid code, or
+			// as soon as reader s has consumed more than bit_counts[s] bits.
+			bool decode_interleaved(BitReader* readers, const uint64_t* bit_counts, unsigned char* out,
+				std::size_t size) const;
+
+			bool is_built(void) const;
+			std::size_t table_size(void) const;
+	};
+
+}
+
+#endif
@@ -0,0 +1,40 @@
+// Compressed file header
+
+#ifndef HUFFMANFILE_H
+#define HUFFMANFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace YNGMAT005 {
+
+	// Marks the start of a compressed file
+	const unsigned char FILE_MAGIC[4] = { 'H', 'U', 'F', 'F' };
+	const unsigned char FILE_VERSION = 1;
+
+	// magic | version (1 byte) | reserved (1 byte) | code table size (2 bytes) |
+	// raw size (8 bytes) | bit count (8 bytes), followed by the code table and
+	// then the packed bits
+	const std::size_t FILE_HEADER_SIZE = 24;
+
+	// Largest code table: a count byte and a (letter, length) pair per byte value
+	const std::size_t MAX_TABLE_SIZE = 1 + 2 * 256;
+
+	// The fixed fields at the start of a compressed file
+	struct FileHeader {
+		uint64_t raw_size;
+		uint64_t bit_count;
+		std::size_t table_size;
+	};
+
+	// append the fixed header fields to 'out'
+	void write_file_header(std::vector<unsigned char> & out, const FileHeader & header);
+	// read the fixed header from the start of a 'file_size' byte file, checking
+	// the magic and version and that the sections it describes fill the file
+	// exactly; 'data' must hold at least FILE_HEADER_SIZE bytes if the file does
+	bool read_file_header(const unsigned char* data, uint64_t file_size, FileHeader & header);
+
+}
+
+#endif
@@ -0,0 +1,47 @@
+// Byte histogram header
+
+#ifndef HUFFMANHISTOGRAM_H
+#define HUFFMANHISTOGRAM_H
+
+#include "huffmanthreadpool.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace YNGMAT005 {
+
+	// Bytes counted into the 32-bit tables before they are merged, small
+	// enough that no table entry can overflow
+	const std::size_t HISTOGRAM_CHUNK_SIZE = std::size_t(1) << 30;
+
+	// Smallest slice of input worth handing to another thread
+	const std::size_t PARALLEL_SLICE_SIZE = std::size_t(1) << 20;
+
+	// Bytes in each block of a sampled histogram
+	const std::size_t SAMPLE_BLOCK_SIZE = std::size_t(1) << 16;
+
+	// Count every byte value is raised to when a histogram has to give all of
+	// them codes: a sample, training data or an adaptive model may not have
+	// seen every byte that will later be coded
+	const uint64_t COUNT_FLOOR = 1;
+
+	// Add the number of occurrences of each byte value in data[0, size) to
+	// 'histogram' (256 entries). Bytes are read a 64-bit word at a time and
+	// spread over four count tables, so that runs of the same byte don't
+	// stall on incrementing one counter.
+	void count_bytes(const unsigned char* data, std::size_t size, uint64_t* histogram);
+
+	// As count_bytes, but the input is split into one slice per pool thread,
+	// each counted into its own table, and the tables are summed at the end
+	void count_bytes(const unsigned char* data, std::size_t size, uint64_t* histogram, ThreadPool & pool);
+
+	// Add the counts of evenly spaced SAMPLE_BLOCK_SIZE blocks covering about
+	// 'fraction' of data[0, size) to 'histogram', or of the whole input when
+	// the sample would be most of it. Returns the number of bytes counted.
+	std::size_t sample_bytes(const unsigned char* data, std::size_t size, uint64_t* histogram, double fraction);
+
+	// raise every count in 'histogram' (256 entries) to at least COUNT_FLOOR
+	void floor_counts(uint64_t* histogram);
+
+}
+
+#endif
@@ -0,0 +1,57 @@
+// Mapped File class header
+
+#ifndef HUFFMANMAPPEDFILE_H
+#define HUFFMANMAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace YNGMAT005 {
+
+	// Read-only view of a whole file. Regular files are memory-mapped so their
+	// bytes are read straight from the page cache; anything that can't be
+	// mapped is read into a buffer with read(2) instead.
+	class MappedFile {
+		private:
+			const unsigned char* view;
+			std::size_t length;
+			std::vector<unsigned char> buffer;
+			bool mapped;
+			bool opened;
+
+			// read the rest of 'fd' into the buffer
+			bool read_all(int fd);
+
+		public:
+			MappedFile(void);
+			~MappedFile(void);
+
+			MappedFile(const MappedFile &) = delete;
+			MappedFile & operator=(const MappedFile &) = delete;
+
+			// open and map a file, hinting to the kernel that it will be read
+			// front to back ('sequential') or jumped around in
+			bool open(const std::string & path, bool sequential);
+			// change the access hint given when the file was opened
+			void advise(bool sequential);
+			// hand the mapped pages of bytes [offset, offset + size) back to the
+			// kernel once they have been read, keeping a last page that runs past
+			// the range; they are read in again if touched
+			void release(std::size_t offset, std::size_t size);
+			// unmap the file, or release its buffer
+			void close(void);
+			// copy the bytes into a buffer and drop the mapping, for when the
+			// file itself is about to be overwritten
+			void detach(void);
+
+			const unsigned char* data(void) const;
+			std::size_t size(void) const;
+			bool is_open(void) const;
+			// true if the bytes come from a mapping rather than a copy
+			bool is_mapped(void) const;
+	};
+
+}
+
+#endif
@@ -3,6 +3,7 @@
 #ifndef HUFFMANNODE_H
 #define HUFFMANNODE_H
 
+#include <cstdint>
 #include <memory>
 #include <string>
 
@@ -13,10 +14,10 @@ namespace YNGMAT005 {
 			std::shared_ptr<HuffmanNode> left;
 			std::shared_ptr<HuffmanNode> right;
 			std::string letter;
-			int frequency;
+			uint64_t frequency;
 
 		public:
-			HuffmanNode(std::string l, int freq);
+			HuffmanNode(std::string l, uint64_t freq);
 			~HuffmanNode(void);
 			std::shared_ptr<HuffmanNode> & get_left(void);
 			std::shared_ptr<HuffmanNode> & get_right(void);
@@ -25,7 +26,7 @@ namespace YNGMAT005 {
 			bool has_left(void);
 			bool has_right(void);
 			std::string get_letter(void);
-			int get_frequency(void);
+			uint64_t get_frequency(void);
 	};
 
 }
@@ -0,0 +1,134 @@
+// Bounded lock-free queue header
+
+#ifndef HUFFMANQUEUE_H
+#define HUFFMANQUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace YNGMAT005 {
+
+	// Times a waiting thread yields before it starts sleeping
+	const unsigned BACKOFF_SPINS = 64;
+
+	// Longest sleep between checks, in microseconds
+	const unsigned BACKOFF_MAX_SLEEP = 200;
+
+	// Waits for a queue to get room or values: a short wait is spent
+	// yielding, and a longer one sleeping for twice as long each time up to
+	// BACKOFF_MAX_SLEEP, so threads with nothing to do give their cores back
+	class Backoff {
+		private:
+			unsigned attempts;
+
+		public:
+			Backoff(void) : attempts(0) {}
+
+			void wait(void) {
+				if(attempts < BACKOFF_SPINS) {
+					attempts++;
+					std::this_thread::yield();
+					return;
+				}
+				unsigned sleep = BACKOFF_MAX_SLEEP;
+				if(attempts - BACKOFF_SPINS < 10) {
+					sleep = std::min(BACKOFF_MAX_SLEEP, 1u << (attempts - BACKOFF_SPINS));
+					attempts++;
+				}
+				std::this_thread::sleep_for(std::chrono::microseconds(sleep));
+			}
+
+			// start over with short waits once there was something to do
+			void reset(void) {
+				attempts = 0;
+			}
+	};
+
+	// Fixed-capacity queue any number of threads can push to and pop from
+	// without locks (Vyukov's bounded MPMC queue). Each cell carries a
+	// sequence number saying whose turn it is, so a push or pop is one
+	// compare-and-swap on the shared position plus a store to the cell.
+	template<typename T>
+	class BoundedQueue {
+		private:
+			struct Cell {
+				std::atomic<std::size_t> sequence;
+				T value;
+			};
+
+			std::unique_ptr<Cell[]> cells;
+			std::size_t mask;
+			// kept on separate cache lines so producers and consumers don't contend
+			alignas(64) std::atomic<std::size_t> push_position;
+			alignas(64) std::atomic<std::size_t> pop_position;
+
+		public:
+			// room for at least 'capacity' values, rounded up to a power of two
+			BoundedQueue(std::size_t capacity) {
+				std::size_t size = 2;
+				while(size < capacity) {
+					size <<= 1;
+				}
+				cells.reset(new Cell[size]);
+				mask = size - 1;
+				for(std::size_t i = 0; i < size; i++) {
+					cells[i].sequence.store(i, std::memory_order_relaxed);
+				}
+				push_position.store(0, std::memory_order_relaxed);
+				pop_position.store(0, std::memory_order_relaxed);
+			}
+
+			BoundedQueue(const BoundedQueue &) = delete;
+			BoundedQueue & operator=(const BoundedQueue &) = delete;
+
+			// move 'value' in, unless the queue is full
+			bool try_push(T & value) {
+				std::size_t position = push_position.load(std::memory_order_relaxed);
+				for(;;) {
+					Cell & cell = cells[position & mask];
+					std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+					std::ptrdiff_t turn = std::ptrdiff_t(sequence) - std::ptrdiff_t(position);
+					if(turn == 0) {
+						if(push_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+							cell.value = std::move(value);
+							cell.sequence.store(position + 1, std::memory_order_release);
+							return true;
+						}
+					} else if(turn < 0) {
+						return false;
+					} else {
+						position = push_position.load(std::memory_order_relaxed);
+					}
+				}
+			}
+
+			// move the oldest value out into 'value', unless the queue is empty
+			bool try_pop(T & value) {
+				std::size_t position = pop_position.load(std::memory_order_relaxed);
+				for(;;) {
+					Cell & cell = cells[position & mask];
+					std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+					std::ptrdiff_t turn = std::ptrdiff_t(sequence) - std::ptrdiff_t(position + 1);
+					if(turn == 0) {
+						if(pop_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+							value = std::move(cell.value);
+							cell.sequence.store(position + mask + 1, std::memory_order_release);
+							return true;
+						}
+					} else if(turn < 0) {
+						return false;
+					} else {
+						position = pop_position.load(std::memory_order_relaxed);
+					}
+				}
+			}
+	};
+
+}
+
+#endif
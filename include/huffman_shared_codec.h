@@ -0,0 +1,61 @@
+// Huffman Shared Codec class header
+
+#ifndef HUFFMANSHAREDCODEC_H
+#define HUFFMANSHAREDCODEC_H
+
+#include "huffmancodetable.h"
+#include "huffmandecoder.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace YNGMAT005 {
+
+	// Longest code a trained table gets unless told otherwise; rare bytes pay
+	// a little more so that lookups stay within a couple of decode tables
+	const unsigned DEFAULT_SHARED_CODE_LENGTH = 16;
+
+	// Compresses many small messages against one code table trained ahead of
+	// time from sample data and shared by both ends, so that messages carry
+	// no code lengths of their own. A message is its raw size as a varint
+	// followed by its packed bits.
+	class HuffmanSharedCodec {
+		private:
+			uint64_t samples[256];
+			HuffmanCodeTable codes;
+			HuffmanDecoder decoder;
+			unsigned max_code_length;
+			unsigned longest;
+
+			// build the decoder and note the longest code once the table is set
+			bool prepare(void);
+
+		public:
+			HuffmanSharedCodec(void);
+
+			// limit code lengths of the trained table to 'length' bits (0 for no limit beyond MAX_CODE_LENGTH)
+			void set_max_code_length(unsigned length);
+			// count the bytes of a sample message
+			void add_sample(const unsigned char* data, std::size_t size);
+			// build the table from the samples added so far, every byte value
+			// getting at least COUNT_FLOOR counts so bytes missing from them still get a (long) code
+			bool train(void);
+
+			// append the table's code lengths to 'out'
+			void serialize(std::vector<unsigned char> & out) const;
+			// use a table written by serialize; 'used' is set to the number of bytes read
+			bool load(const unsigned char* data, std::size_t size, std::size_t & used);
+			// true once a table has been trained or loaded
+			bool is_ready(void) const;
+			const HuffmanCodeTable & get_codes(void) const;
+
+			// compress data[0, size) into 'out', reusing its capacity; false if
+			// there is no table or a byte has no code in it
+			bool compress(const unsigned char* data, std::size_t size, std::vector<unsigned char> & out) const;
+			// decompress a message written by compress into 'out', reusing its capacity
+			bool decompress(const unsigned char* data, std::size_t size, std::vector<unsigned char> & out) const;
+	};
+
+}
+
+#endif
@@ -0,0 +1,58 @@
+// Thread Pool class header
+
+#ifndef HUFFMANTHREADPOOL_H
+#define HUFFMANTHREADPOOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace YNGMAT005 {
+
+	// Fixed set of worker threads running queued tasks in submission order
+	class ThreadPool {
+		private:
+			std::vector<std::thread> workers;
+			std::queue<std::function<void(void)>> tasks;
+			std::mutex lock;
+			std::condition_variable ready;
+			bool stopping;
+
+			void work(void);
+
+		public:
+			// start 'threads' workers (0 for one per hardware thread)
+			ThreadPool(unsigned threads);
+			// finish the queued tasks, then join the workers
+			~ThreadPool(void);
+
+			ThreadPool(const ThreadPool &) = delete;
+			ThreadPool & operator=(const ThreadPool &) = delete;
+
+			// queue a task and get a future for its result
+			template<typename F>
+			std::future<typename std::result_of<F()>::type> submit(F task) {
+				typedef typename std::result_of<F()>::type result_type;
+				std::shared_ptr<std::packaged_task<result_type()>> job =
+					std::make_shared<std::packaged_task<result_type()>>(task);
+				std::future<result_type> result = job->get_future();
+				{
+					std::lock_guard<std::mutex> guard(lock);
+					tasks.push([job]() { (*job)(); });
+				}
+				ready.notify_one();
+				return result;
+			}
+
+			unsigned size(void) const;
+	};
+
+}
+
+#endif
@@ -4,16 +4,30 @@
 #define HUFFMANTREE_H
 
 #include "huffmannode.h"
+#include "huffmancodetable.h"
+#include "huffmanarena.h"
+#include "huffmandecoder.h"
+#include "huffmanmappedfile.h"
+#include "huffmanfile.h"
 #include <string>
+#include <ostream>
+#include <fstream>
 #include <queue>
 #include <unordered_map>
 #include <functional>
 #include <memory>
 #include <vector>
 #include <map>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
 
 namespace YNGMAT005 {
 
+	// Size of the chunks input files are encoded in
+	const std::size_t READ_BLOCK_SIZE = 1 << 20;
+
 	// Comparator class used to compare two nodes
 	class Comparator {
 		public:
@@ -24,15 +38,37 @@ namespace YNGMAT005 {
 	class HuffmanTree {
 
 		private:
-			std::priority_queue<HuffmanNode, std::vector<HuffmanNode>, Comparator> nodes;
-			std::unordered_map<std::string, int> frequencies;
-			std::unordered_map<std::string, std::string> code_table;
+			HuffmanArena arena;
+			std::array<uint64_t, 256> histogram;
+			HuffmanCodeTable codes;
 			std::shared_ptr<HuffmanNode> root;
 			std::string input_file, output_file, encoded_data;
-			std::vector<std::string> original_data;
-			std::vector<std::shared_ptr<HuffmanNode>> all_nodes;
+			// the input file's bytes, mapped rather than copied; copies of the tree share the mapping
+			std::shared_ptr<MappedFile> input;
+			unsigned max_code_length;
+			unsigned threads;
+			// share of a large input counted to estimate the histogram (0 to count it all),
+			// and whether the current histogram is such an estimate
+			double sample_fraction;
+			bool sampled;
 			bool loaded;
 
+			// record the depth of every leaf below 'node' as its code length
+			void measure_depths(std::shared_ptr<HuffmanNode> node, unsigned depth, unsigned char* lengths);
+			// assign canonical codes from code lengths, limiting them if needed,
+			// and reshape the tree so that its paths match the codes
+			void finish_code_table(unsigned char* lengths);
+			// map the input file and count each byte value; with 'release', count it
+			// a READ_BLOCK_SIZE chunk at a time and hand each chunk's pages back once counted
+			void load_data(bool release);
+			// number of bits the input encodes to
+			uint64_t count_bits(void);
+			// write the compressed file's fixed header and code table for 'bit_count' bits
+			void write_header(std::ostream & out, uint64_t bit_count);
+			// map the compressed file, check its header and build the decoder from
+			// its code table, setting 'offset' to where the packed bits start
+			bool open_bit_stream(MappedFile & bit_file, HuffmanDecoder & decoder, FileHeader & header, std::size_t & offset);
+
 		public:
 			// Special member functions
 
@@ -53,12 +89,17 @@ namespace YNGMAT005 {
 				if(root != nullptr) {
       				root = nullptr;
     			}
-				nodes = tree.nodes;
-				frequencies = tree.frequencies;
-				code_table = tree.code_table;
+				arena = tree.arena;
+				histogram = tree.histogram;
+				codes = tree.codes;
 				root = tree.root;
 				input_file = tree.input_file;
 				output_file = tree.output_file;
+				input = tree.input;
+				max_code_length = tree.max_code_length;
+				threads = tree.threads;
+				sample_fraction = tree.sample_fraction;
+				sampled = tree.sampled;
 				loaded = tree.loaded;
 				return *this;
 			}
@@ -68,41 +109,62 @@ namespace YNGMAT005 {
 				if(root != nullptr) {
       				root = nullptr;
     			}
-				nodes = std::move(tree.nodes);
-				frequencies = std::move(tree.frequencies);
-				code_table = std::move(tree.code_table);
+				arena = tree.arena;
+				histogram = tree.histogram;
+				codes = tree.codes;
 				root = std::move(tree.root);
 				input_file = std::move(tree.input_file);
 				output_file = std::move(tree.output_file);
+				input = tree.input;
+				max_code_length = tree.max_code_length;
+				threads = tree.threads;
+				sample_fraction = tree.sample_fraction;
+				sampled = tree.sampled;
 				loaded = std::move(tree.loaded);
 				return *this;
 			}
 
+			// linked view of the tree, copied out of the arena on first use
 			std::shared_ptr<HuffmanNode> & get_root(void);
 			// convenience method to create and build a Huffman Tree
 			void run(void);
 			// build tree
 			void build_tree(void);
-			// load data from text file
+			// map the input file and count each byte value
 			void load_data(void);
-			// build code table of characters
+			// build canonical code table of characters from the depths of the tree's leaves,
+			// and reshape the tree so that its paths match the canonical codes
+			void build_code_table(void);
+			// as above, measuring depths in a linked tree starting 'code' bits deep
 			void build_code_table(std::shared_ptr<HuffmanNode> root, std::string code);
-			// write the code table to a test file
-			void export_code_table(void);
-			// write the 'compressed' bit stream to the output file
+			// write the codes of the input as '0' and '1' characters to a text file, for inspection
 			void compress_data(void);
 
 			// Extra credit
 
-			// write the bitstream to a binary file
+			// write the compressed file: a fixed header, the code lengths and the packed bits
 			void write_bits(void);
+			// compress the input file straight to the compressed file, encoding it in
+			// READ_BLOCK_SIZE chunks so memory use doesn't grow with the file
+			bool stream_bits(void);
+			// compress the input file into a block container with a tree per block,
+			// encoding the blocks on the tree's threads
+			bool write_blocks(std::size_t block_size);
+			// decode the block container back into 'out'
+			bool read_blocks(std::ostream & out);
+			// decode only bytes [offset, offset + length) of the input from the block container
+			bool read_range(uint64_t offset, uint64_t length, std::string & out);
 			// pack text file data bits into an array of unsigned chars
-			void pack(unsigned char* bytes, int BUFFER_SIZE, std::vector<std::string> & data);
+			void pack(unsigned char* bytes, std::size_t BUFFER_SIZE, const unsigned char* data, std::size_t size);
 			// unpack text file data from an array of unsigned chars
-			std::string unpack(unsigned char* bytes, int BUFFER_SIZE, int shift_offset);
-			// read the bitstream from a binary file
+			std::string unpack(unsigned char* bytes, std::size_t BUFFER_SIZE, int shift_offset);
+			// decode the compressed file ("" if it is corrupt)
 			std::string read_bits(void);
-			// search the Huffman Tree to decode the read bits
+			// decode the compressed file, writing the decoded bytes to 'out'
+			// as they are produced so memory use doesn't grow with the file;
+			// false if it is corrupt
+			bool read_bits(std::ostream & out);
+			// search the Huffman Tree for the letter a code leads to
 			std::string search_tree(std::shared_ptr<HuffmanNode> root, std::string code);		
 
 // ==================== Methods for Testing ====================
@@ -110,10 +172,19 @@ namespace YNGMAT005 {
 			HuffmanTree(std::string input_file, std::string output_file);
 			void set_output_file(std::string output_file);
 			void set_input_file(std::string input_file);
+			// limit code lengths to 'length' bits (0 for no limit beyond MAX_CODE_LENGTH)
+			void set_max_code_length(unsigned length);
+			// number of threads used to count frequencies and encode blocks (0 for one per hardware thread)
+			void set_threads(unsigned threads);
+			// build the tree from evenly spaced blocks covering about 'fraction' of the
+			// input (0 to count every byte); every byte value then gets a code, and the
+			// frequency table only holds the sample's counts
+			void set_sample_fraction(double fraction);
 			bool has_loaded(void);
 			void print_tree(std::shared_ptr<HuffmanNode> root, std::string prefix);
 			void print_codes(void);
-			std::unordered_map<std::string, int> get_frequency_table();
+			std::unordered_map<std::string, uint64_t> get_frequency_table();
+			// codes as strings of '0' and '1' characters, keyed by letter
 			std::unordered_map<std::string, std::string> get_code_table();
 			std::string get_encoded_data();
 	};
@@ -34,19 +34,16 @@ void handleInput(int argc, char* argv[]) {
 				cout << "Data loaded successfully." << endl;
 				cout << "Building Huffman Tree..." << endl;
 				tree.build_tree();
-				cout << "Exporting code table to \"" << string(argv[2]) << ".hdr\"..." << endl;
-				tree.build_code_table(tree.get_root(), "");
-				tree.export_code_table();
-				cout << "Exporting 'compressed' data to \"" << string(argv[2]) << "\"..." << endl;
-				tree.compress_data();
-				cout << "Writing compressed bit stream to \"" << string(argv[2]) << ".bin\"..." << endl;
+				cout << "Building code table..." << endl;
+				tree.build_code_table();
+				cout << "Writing compressed file to \"" << string(argv[2]) << ".huf\"..." << endl;
 				tree.write_bits();
 				cout << "Operations completed.\n" << endl;
 
 				for(;;) {
 					cout << "Perform an operation on the tree by choosing an option below:\n" << endl;
 					cout << "1: Print Huffman Tree code table" << endl;
-					cout << "2: Read bit stream from \"" << string(argv[2]) << ".bin\"" << endl;
+					cout << "2: Read compressed file \"" << string(argv[2]) << ".huf\"" << endl;
 					cout << "3: Print Huffman Tree representation" << endl;
 					cout << "0: Quit" << endl;
 					cout << "Enter an option: ";
@@ -0,0 +1,264 @@
+// Adaptive Huffman coding definitions
+
+#include "huffmanadaptive.h"
+#include "huffmanarena.h"
+#include "huffmanbits.h"
+#include "huffmancodetable.h"
+#include "huffmandecoder.h"
+#include "huffmanhistogram.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+using namespace std;
+
+namespace YNGMAT005 {
+
+  AdaptiveModel::AdaptiveModel(size_t interval) {
+    this->reset(interval);
+  }
+
+  void AdaptiveModel::reset(size_t interval) {
+    this->interval = interval == 0 ? ADAPTIVE_REBUILD_INTERVAL : interval;
+    this->reset();
+  }
+
+  void AdaptiveModel::reset() {
+    // every byte value needs a code before it has been seen
+    fill(counts, counts + 256, 0);
+    floor_counts(counts);
+    total = 256 * COUNT_FLOOR;
+    since_rebuild = 0;
+    this->rebuild();
+  }
+
+  void AdaptiveModel::rebuild() {
+    arena.build(counts);
+    unsigned char lengths[256] = {0};
+    arena.code_lengths(lengths);
+    codes.build(lengths, counts, 0);
+    since_rebuild = 0;
+  }
+
+  bool AdaptiveModel::update(const unsigned char* data, size_t size) {
+    count_bytes(data, size, counts);
+    total += size;
+    since_rebuild += size;
+
+    // halve the counts, keeping every byte value at the floor or more
+    while(total > ADAPTIVE_COUNT_LIMIT) {
+      total = 0;
+      for(int i = 0; i < 256; i++) {
+        counts[i] = max((counts[i] + 1) / 2, COUNT_FLOOR);
+        total += counts[i];
+      }
+    }
+
+    if(since_rebuild < interval) {
+      return false;
+    }
+    this->rebuild();
+    return true;
+  }
+
+  const HuffmanCodeTable & AdaptiveModel::get_codes() const {
+    return codes;
+  }
+
+  size_t AdaptiveModel::get_interval() const {
+    return interval;
+  }
+
+  AdaptiveEncoder::AdaptiveEncoder(size_t interval) : model(interval) {
+    longest = 8;
+    chunk_size = interval == 0 ? ADAPTIVE_CHUNK_SIZE : min(interval, ADAPTIVE_CHUNK_SIZE);
+    started = false;
+  }
+
+  void AdaptiveEncoder::reset() {
+    model.reset();
+    longest = 8;
+    started = false;
+  }
+
+  void AdaptiveEncoder::start(vector<unsigned char> & out) {
+    if(!started) {
+      put_varint(out, model.get_interval());
+      started = true;
+    }
+  }
+
+  void AdaptiveEncoder::encode(const unsigned char* data, size_t size, vector<unsigned char> & out) {
+    if(size == 0) {
+      return;
+    }
+    this->start(out);
+
+    // pack into the end of 'out' with room for the longest codes, then
+    // move the bits up behind the two size fields once their sizes are known
+    const HuffmanCodeTable & codes = model.get_codes();
+    size_t start = out.size();
+    out.resize(start + (size * longest + 7) / 8 + 8);
+    BitWriter writer(&out[start], out.size() - start);
+    for(size_t i = 0; i < size; i++) {
+      const HuffmanCode & code = codes.get(data[i]);
+      writer.write(code.bits, code.length);
+    }
+    writer.flush();
+    size_t packed_size = writer.bytes();
+
+    vector<unsigned char> fields;
+    put_varint(fields, size);
+    put_varint(fields, packed_size);
+    out.resize(start + fields.size() + packed_size);
+    copy_backward(out.begin() + start, out.begin() + start + packed_size, out.end());
+    copy(fields.begin(), fields.end(), out.begin() + start);
+
+    // the decoder sees these bytes before its next chunk too
+    if(model.update(data, size)) {
+      longest = 0;
+      for(int i = 0; i < 256; i++) {
+        longest = max(longest, unsigned(model.get_codes().get(i).length));
+      }
+    }
+  }
+
+  void AdaptiveEncoder::finish(vector<unsigned char> & out) {
+    this->start(out);
+    put_varint(out, 0);
+  }
+
+  bool AdaptiveEncoder::compress(istream & in, ostream & out) {
+    vector<unsigned char> chunk(chunk_size), frame;
+    while(in) {
+      in.read((char*)chunk.data(), chunk.size());
+      frame.clear();
+      this->encode(chunk.data(), in.gcount(), frame);
+      out.write((const char*)frame.data(), frame.size());
+    }
+    frame.clear();
+    this->finish(frame);
+    out.write((const char*)frame.data(), frame.size());
+    return out.good();
+  }
+
+  AdaptiveDecoder::AdaptiveDecoder() : model(0) {
+    started = false;
+  }
+
+  void AdaptiveDecoder::reset() {
+    started = false;
+  }
+
+  bool AdaptiveDecoder::decode(const unsigned char* data, size_t size, size_t & used, vector<unsigned char> & out,
+    bool & finished) {
+    out.clear();
+    finished = false;
+
+    // the stream's first frame follows the encoder's rebuild interval
+    size_t interval_field = 0;
+    if(!started) {
+      uint64_t interval = 0;
+      if(!get_varint(data, size, interval, interval_field) || interval == 0 || size_t(interval) != interval) {
+        return false;
+      }
+      model.reset(interval);
+      decoder.build(model.get_codes());
+      started = true;
+      data += interval_field;
+      size -= interval_field;
+    }
+
+    uint64_t raw_size = 0, packed_size = 0;
+    size_t raw_field = 0, packed_field = 0;
+    if(!get_varint(data, size, raw_size, raw_field)) {
+      return false;
+    }
+    if(raw_size == 0) {
+      used = interval_field + raw_field;
+      finished = true;
+      return true;
+    }
+    if(!get_varint(data + raw_field, size - raw_field, packed_size, packed_field)) {
+      return false;
+    }
+
+    size_t header = raw_field + packed_field;
+    if(packed_size > size - header || !fits_packed_bytes(raw_size, packed_size)) {
+      return false;
+    }
+    out.resize(raw_size);
+
+    // decode exactly raw_size bytes; only the last byte's padding may be left over
+    BitReader reader(data + header, packed_size);
+    size_t written = 0;
+    if(!decoder.decode(reader, packed_size * 8, out.data(), out.size(), written) || written != raw_size ||
+      (reader.consumed() + 7) / 8 != packed_size) {
+      out.clear();
+      return false;
+    }
+    used = interval_field + header + packed_size;
+
+    // follow the encoder's model
+    if(model.update(out.data(), out.size())) {
+      decoder.build(model.get_codes());
+    }
+    return true;
+  }
+
+  bool AdaptiveDecoder::read_field(istream & in, uint64_t & value) {
+    size_t start = packed.size(), used = 0;
+    int byte = 0;
+    do {
+      byte = in.get();
+      if(byte == istream::traits_type::eof() || packed.size() - start == 10) {
+        return false;
+      }
+      packed.push_back(byte);
+    } while(byte & 0x80);
+    return get_varint(&packed[start], packed.size() - start, value, used);
+  }
+
+  bool AdaptiveDecoder::decompress(istream & in, ostream & out) {
+    vector<unsigned char> decoded;
+    for(;;) {
+      // the rebuild interval before the first frame, then the two size fields
+      packed.clear();
+      uint64_t interval = 0, raw_size = 0, packed_size = 0;
+      if((!started && !this->read_field(in, interval)) || !this->read_field(in, raw_size)) {
+        return false;
+      }
+
+      // a raw size of 0 ends the stream and has no packed size
+      if(raw_size != 0) {
+        if(!this->read_field(in, packed_size) || !fits_packed_bytes(raw_size, packed_size)) {
+          return false;
+        }
+
+        // the sizes only agree with each other, so the bits are read a chunk
+        // at a time and a stream that ends early is found before much is allocated
+        size_t header = packed.size();
+        while(packed.size() - header < packed_size) {
+          size_t read = packed.size();
+          packed.resize(read + min(uint64_t(STREAM_CHUNK_SIZE), packed_size - (read - header)));
+          if(!in.read((char*)&packed[read], packed.size() - read)) {
+            return false;
+          }
+        }
+      }
+
+      size_t used = 0;
+      bool finished = false;
+      if(!this->decode(packed.data(), packed.size(), used, decoded, finished)) {
+        return false;
+      }
+      if(finished) {
+        return out.good();
+      }
+      out.write((const char*)decoded.data(), decoded.size());
+    }
+  }
+}
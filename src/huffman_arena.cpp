@@ -0,0 +1,195 @@
+// Huffman Arena class definitions
+
+#include "huffmanarena.h"
+#include "huffmannode.h"
+#include "huffmancodetable.h"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace YNGMAT005 {
+
+  HuffmanArena::HuffmanArena() {
+    nodes.reserve(MAX_ARENA_NODES);
+    root = NO_NODE;
+  }
+
+  void HuffmanArena::clear() {
+    // keeps the capacity, so rebuilding doesn't allocate
+    nodes.clear();
+    root = NO_NODE;
+  }
+
+  uint32_t HuffmanArena::add_leaf(unsigned char letter, uint64_t frequency) {
+    ArenaNode leaf = { frequency, NO_NODE, NO_NODE, letter };
+    nodes.push_back(leaf);
+    return nodes.size() - 1;
+  }
+
+  uint32_t HuffmanArena::add_parent(uint32_t left, uint32_t right) {
+    uint64_t frequency = 0;
+    if(left != NO_NODE) {
+      frequency += nodes[left].frequency;
+    }
+    if(right != NO_NODE) {
+      frequency += nodes[right].frequency;
+    }
+    ArenaNode parent = { frequency, left, right, 0 };
+    nodes.push_back(parent);
+    return nodes.size() - 1;
+  }
+
+  void HuffmanArena::build(const uint64_t* frequencies) {
+    this->clear();
+
+    // sort the letters by frequency once, with ties in byte order
+    pair<uint64_t, unsigned char> sorted[256];
+    uint32_t count = 0;
+    for(int i = 0; i < 256; i++) {
+      if(frequencies[i] != 0) {
+        sorted[count++] = pair<uint64_t, unsigned char>(frequencies[i], i);
+      }
+    }
+    if(count == 0) {
+      return;
+    }
+    sort(sorted, sorted + count);
+
+    // leaves take indices [0, count) in sorted order
+    for(uint32_t i = 0; i < count; i++) {
+      this->add_leaf(sorted[i].second, sorted[i].first);
+    }
+
+    // two queues: the sorted leaves, and the parents in the order they are
+    // made, which is also sorted. The lightest subtree is always at the front
+    // of one of them, so each join is constant time.
+    uint32_t next_leaf = 0, next_parent = count;
+    for(uint32_t joins = 1; joins < count; joins++) {
+      uint32_t children[2];
+      for(int c = 0; c < 2; c++) {
+        // prefer leaves on ties, which keeps the tree shallow
+        if(next_leaf < count && (next_parent == nodes.size() || nodes[next_leaf].frequency <= nodes[next_parent].frequency)) {
+          children[c] = next_leaf++;
+        } else {
+          children[c] = next_parent++;
+        }
+      }
+      this->add_parent(children[0], children[1]);
+    }
+    root = nodes.size() - 1;
+  }
+
+  void HuffmanArena::build_canonical(const HuffmanCodeTable & codes, const uint64_t* frequencies) {
+    this->clear();
+
+    // left-aligned codes in order, so each subtree is a contiguous range
+    pair<uint64_t, unsigned char> sorted[256];
+    uint32_t count = 0;
+    for(int i = 0; i < 256; i++) {
+      const HuffmanCode & code = codes.get(i);
+      if(code.length != 0) {
+        sorted[count++] = pair<uint64_t, unsigned char>(code.bits << (64 - code.length), i);
+      }
+    }
+    if(count == 0) {
+      return;
+    }
+    sort(sorted, sorted + count);
+
+    uint64_t leaves[256];
+    unsigned char letters[256];
+    for(uint32_t i = 0; i < count; i++) {
+      leaves[i] = sorted[i].first;
+      letters[i] = sorted[i].second;
+    }
+    root = this->add_canonical(codes, frequencies, leaves, letters, 0, count, 0);
+  }
+
+  uint32_t HuffmanArena::add_canonical(const HuffmanCodeTable & codes, const uint64_t* frequencies,
+    const uint64_t* leaves, const unsigned char* letters, uint32_t first, uint32_t last, unsigned depth) {
+    // a single code that ends here is a leaf
+    if(last - first == 1 && codes.get(letters[first]).length == depth) {
+      return this->add_leaf(letters[first], frequencies[letters[first]]);
+    }
+
+    // codes with a 0 at this depth come first
+    uint32_t split = first;
+    while(split < last && ((leaves[split] << depth) >> 63) == 0) {
+      split++;
+    }
+
+    uint32_t left = NO_NODE, right = NO_NODE;
+    if(split > first) {
+      left = this->add_canonical(codes, frequencies, leaves, letters, first, split, depth + 1);
+    }
+    if(last > split) {
+      right = this->add_canonical(codes, frequencies, leaves, letters, split, last, depth + 1);
+    }
+    return this->add_parent(left, right);
+  }
+
+  void HuffmanArena::code_lengths(unsigned char* lengths) const {
+    if(root == NO_NODE) {
+      return;
+    }
+
+    // depth-first walk with an explicit stack of (node, depth)
+    pair<uint32_t, unsigned> stack[MAX_ARENA_NODES];
+    size_t top = 0;
+    stack[top++] = pair<uint32_t, unsigned>(root, 0);
+
+    while(top > 0) {
+      pair<uint32_t, unsigned> current = stack[--top];
+      const ArenaNode & node = nodes[current.first];
+
+      if(this->is_leaf(current.first)) {
+        // a tree of a single letter still needs one bit per letter
+        lengths[node.letter] = current.second == 0 ? 1 : current.second;
+        continue;
+      }
+      if(node.left != NO_NODE) {
+        stack[top++] = pair<uint32_t, unsigned>(node.left, current.second + 1);
+      }
+      if(node.right != NO_NODE) {
+        stack[top++] = pair<uint32_t, unsigned>(node.right, current.second + 1);
+      }
+    }
+  }
+
+  shared_ptr<HuffmanNode> HuffmanArena::to_nodes(uint32_t index) const {
+    if(index == NO_NODE) {
+      return nullptr;
+    }
+
+    const ArenaNode & node = nodes[index];
+    string letter = this->is_leaf(index) ? string(1, node.letter) : "";
+    shared_ptr<HuffmanNode> copy = make_shared<HuffmanNode>(letter, node.frequency);
+
+    shared_ptr<HuffmanNode> left = this->to_nodes(node.left);
+    shared_ptr<HuffmanNode> right = this->to_nodes(node.right);
+    if(left) {
+      copy->set_left(left);
+    }
+    if(right) {
+      copy->set_right(right);
+    }
+    return copy;
+  }
+
+  uint32_t HuffmanArena::get_root() const {
+    return root;
+  }
+
+  size_t HuffmanArena::size() const {
+    return nodes.size();
+  }
+
+  bool HuffmanArena::empty() const {
+    return root == NO_NODE;
+  }
+}
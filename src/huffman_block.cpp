@@ -0,0 +1,613 @@
+// Block container definitions
+
+#include "huffmanblock.h"
+#include "huffmanarena.h"
+#include "huffmanbits.h"
+#include "huffmancodetable.h"
+#include "huffmandecoder.h"
+#include "huffmanhistogram.h"
+#include "huffmanqueue.h"
+#include "huffmanthreadpool.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace YNGMAT005 {
+
+  BlockCompressor::BlockCompressor(size_t block_size, unsigned threads) {
+    this->block_size = block_size == 0 ? DEFAULT_BLOCK_SIZE : block_size;
+    this->threads = threads;
+    this->max_code_length = 0;
+    this->streams = DECODE_STREAMS;
+    this->checkpoint_interval = DEFAULT_CHECKPOINT_INTERVAL;
+  }
+
+  void BlockCompressor::set_max_code_length(unsigned length) {
+    max_code_length = length;
+  }
+
+  bool BlockCompressor::set_streams(unsigned streams) {
+    if(streams != 1 && streams != DECODE_STREAMS) {
+      return false;
+    }
+    this->streams = streams;
+    return true;
+  }
+
+  void BlockCompressor::set_checkpoint_interval(size_t interval) {
+    checkpoint_interval = (interval + DECODE_STREAMS - 1) / DECODE_STREAMS * DECODE_STREAMS;
+  }
+
+  void BlockCompressor::encode_block(const unsigned char* data, size_t size, vector<unsigned char> & frame) const {
+    vector<uint64_t> checkpoints;
+    this->encode_block(data, size, frame, checkpoints);
+  }
+
+  void BlockCompressor::encode_block(const unsigned char* data, size_t size, vector<unsigned char> & frame,
+    vector<uint64_t> & checkpoints) const {
+    HuffmanArena arena;
+    this->encode_block(data, size, frame, checkpoints, arena);
+  }
+
+  void BlockCompressor::encode_block(const unsigned char* data, size_t size, vector<unsigned char> & frame,
+    vector<uint64_t> & checkpoints, HuffmanArena & arena) const {
+    // a tree of this block's own letters
+    uint64_t histogram[256] = {0};
+    count_bytes(data, size, histogram);
+    arena.build(histogram);
+
+    unsigned char lengths[256] = {0};
+    arena.code_lengths(lengths);
+    HuffmanCodeTable codes;
+    codes.build(lengths, histogram, max_code_length);
+
+    // bits going into each stream
+    uint64_t stream_bits[DECODE_STREAMS] = {0};
+    if(streams == 1) {
+      for(int i = 0; i < 256; i++) {
+        stream_bits[0] += histogram[i] * codes.get(i).length;
+      }
+    } else {
+      for(size_t i = 0; i < size; i++) {
+        stream_bits[i % streams] += codes.get(data[i]).length;
+      }
+    }
+    uint64_t bit_count = 0;
+    for(unsigned s = 0; s < streams; s++) {
+      bit_count += stream_bits[s];
+    }
+
+    put_le(frame, size, 8);
+    put_le(frame, bit_count, 8);
+    codes.serialize(frame);
+    frame.push_back(streams);
+    for(unsigned s = 0; s + 1 < streams; s++) {
+      put_le(frame, stream_bits[s], 8);
+    }
+
+    // pack the bits after the header, with room for the writer's word stores;
+    // streams are written one after another so a word store running past the
+    // end of one only touches bytes of the next that are still to be written
+    size_t offset = frame.size();
+    size_t payload_size = 0;
+    for(unsigned s = 0; s < streams; s++) {
+      payload_size += (stream_bits[s] + 7) / 8;
+    }
+    frame.resize(offset + payload_size + 8);
+
+    // the interval is a multiple of the stream count, so each checkpoint is
+    // where every stream is about to take its next byte
+    size_t interval = checkpoint_interval != 0 ? checkpoint_interval : size;
+    size_t checkpoint_count = checkpoint_interval != 0 && size != 0 ? (size - 1) / interval : 0;
+    checkpoints.assign(checkpoint_count * streams, 0);
+
+    for(unsigned s = 0; s < streams; s++) {
+      BitWriter writer(&frame[offset], frame.size() - offset);
+      size_t i = s;
+      for(size_t k = 0; k <= checkpoint_count; k++) {
+        if(k > 0) {
+          checkpoints[(k - 1) * streams + s] = writer.written();
+        }
+        size_t last = k < checkpoint_count ? (k + 1) * interval : size;
+        for(; i < last; i += streams) {
+          const HuffmanCode & code = codes.get(data[i]);
+          writer.write(code.bits, code.length);
+        }
+      }
+      writer.flush();
+      offset += writer.bytes();
+    }
+    frame.resize(offset);
+  }
+
+  bool BlockCompressor::compress(istream & in, ostream & out) const {
+    size_t block_size = this->block_size;
+    return this->write_container([&in, block_size](const unsigned char* & data, size_t & size,
+      shared_ptr<vector<unsigned char>> & owner) {
+      owner = make_shared<vector<unsigned char>>(block_size);
+      in.read((char*)owner->data(), block_size);
+      owner->resize(in.gcount());
+      data = owner->data();
+      size = owner->size();
+      return size != 0;
+    }, out);
+  }
+
+  bool BlockCompressor::compress(const unsigned char* data, size_t size, ostream & out) const {
+    size_t block_size = this->block_size;
+    size_t offset = 0;
+    return this->write_container([data, size, block_size, &offset](const unsigned char* & block, size_t & length,
+      shared_ptr<vector<unsigned char>> &) {
+      block = data + offset;
+      length = min(block_size, size - offset);
+      offset += length;
+      return length != 0;
+    }, out);
+  }
+
+  // A block read in and waiting for an encoder
+  struct BlockJob {
+    uint64_t sequence;
+    const unsigned char* data;
+    size_t size;
+    shared_ptr<vector<unsigned char>> owner;
+  };
+
+  // A block encoded and waiting for its turn to be written
+  struct EncodedBlock {
+    uint64_t sequence;
+    uint64_t raw_size;
+    vector<unsigned char> frame;
+    vector<uint64_t> checkpoints;
+  };
+
+  bool BlockCompressor::write_container(function<bool(const unsigned char* &, size_t &,
+    shared_ptr<vector<unsigned char>> &)> next, ostream & out) const {
+    BlockWriter writer(out, checkpoint_interval);
+
+    unsigned encoders = threads != 0 ? threads : max(1u, thread::hardware_concurrency());
+    uint64_t in_flight = 2 * encoders;
+    BoundedQueue<BlockJob> jobs(in_flight);
+    BoundedQueue<EncodedBlock> encoded(in_flight);
+    atomic<uint64_t> read_count(0), written_count(0);
+    atomic<bool> reading(true);
+
+    // reader: hand out blocks as long as few enough are waiting to be written
+    thread reader([&]() {
+      for(;;) {
+        Backoff backoff;
+        while(read_count.load() - written_count.load() >= in_flight) {
+          backoff.wait();
+        }
+        BlockJob job;
+        if(!next(job.data, job.size, job.owner)) {
+          break;
+        }
+        job.sequence = read_count.load();
+        backoff.reset();
+        while(!jobs.try_push(job)) {
+          backoff.wait();
+        }
+        read_count++;
+      }
+      reading = false;
+    });
+
+    // encoders: each keeps its own arena for all the blocks it encodes
+    vector<thread> workers;
+    for(unsigned w = 0; w < encoders; w++) {
+      workers.push_back(thread([&]() {
+        HuffmanArena arena;
+        Backoff backoff;
+        for(;;) {
+          // once reading is over, an empty queue means there is nothing left
+          bool finished = !reading.load();
+          BlockJob job;
+          if(jobs.try_pop(job)) {
+            EncodedBlock block;
+            block.sequence = job.sequence;
+            block.raw_size = job.size;
+            this->encode_block(job.data, job.size, block.frame, block.checkpoints, arena);
+            job.owner.reset();
+            backoff.reset();
+            while(!encoded.try_push(block)) {
+              backoff.wait();
+            }
+            backoff.reset();
+          } else if(finished) {
+            break;
+          } else {
+            backoff.wait();
+          }
+        }
+      }));
+    }
+
+    // writer: blocks finish out of order, so each waits in the slot for its
+    // sequence number until the ones before it are written
+    vector<EncodedBlock> slots(in_flight);
+    vector<bool> ready(in_flight, false);
+    Backoff backoff;
+    for(;;) {
+      bool finished = !reading.load();
+      EncodedBlock block;
+      if(encoded.try_pop(block)) {
+        backoff.reset();
+        size_t slot = block.sequence % in_flight;
+        slots[slot] = move(block);
+        ready[slot] = true;
+        for(slot = written_count.load() % in_flight; ready[slot]; slot = written_count.load() % in_flight) {
+          writer.write(slots[slot].frame, slots[slot].raw_size, slots[slot].checkpoints);
+          ready[slot] = false;
+          written_count++;
+        }
+      } else if(finished && written_count.load() == read_count.load()) {
+        break;
+      } else {
+        backoff.wait();
+      }
+    }
+
+    reader.join();
+    for(auto& worker : workers) {
+      worker.join();
+    }
+    return writer.finish();
+  }
+
+  BlockWriter::BlockWriter(ostream & out, size_t interval) : out(out) {
+    this->offset = 5;
+    this->interval = interval;
+    out.write((const char*)BLOCK_MAGIC, 4);
+    out.put(BLOCK_VERSION);
+  }
+
+  void BlockWriter::write(const vector<unsigned char> & frame, uint64_t raw_size, const vector<uint64_t> & checkpoints) {
+    // checkpoints are placed relative to the index until the table's size is known
+    BlockEntry entry = { offset, 0, raw_size, index.size(), interval };
+    table.push_back(entry);
+    for(auto bits : checkpoints) {
+      put_le(index, bits, 8);
+    }
+    out.write((const char*)frame.data(), frame.size());
+    offset += frame.size();
+  }
+
+  bool BlockWriter::finish() {
+    // a raw size of 0 ends the blocks, then the table, the checkpoints and the footer follow
+    vector<unsigned char> end;
+    put_le(end, 0, 8);
+    uint64_t table_offset = offset + end.size();
+    uint64_t index_offset = table_offset + table.size() * TABLE_ENTRY_SIZE;
+    for(auto& entry : table) {
+      put_le(end, entry.offset, 8);
+      put_le(end, entry.raw_size, 8);
+      put_le(end, index_offset + entry.checkpoints, 8);
+    }
+    end.insert(end.end(), index.begin(), index.end());
+    put_le(end, table.size(), 8);
+    put_le(end, table_offset, 8);
+    put_le(end, interval, 8);
+    end.insert(end.end(), TABLE_MAGIC, TABLE_MAGIC + 4);
+    out.write((const char*)end.data(), end.size());
+    return out.good();
+  }
+
+  BlockDecompressor::BlockDecompressor() {
+    threads = 1;
+  }
+
+  BlockDecompressor::BlockDecompressor(unsigned threads) {
+    this->threads = threads;
+  }
+
+  bool BlockDecompressor::read_header(const unsigned char* data, size_t size, BlockHeader & header) {
+    if(size < BLOCK_FIELDS_SIZE) {
+      return false;
+    }
+    header.raw_size = get_le(data, 8);
+    header.bit_count = get_le(data + 8, 8);
+
+    size_t used = 0;
+    if(!header.codes.deserialize(data + BLOCK_FIELDS_SIZE, size - BLOCK_FIELDS_SIZE, used)) {
+      return false;
+    }
+    header.header_size = BLOCK_FIELDS_SIZE + used;
+
+    // stream count and the bit counts of all streams but the last
+    if(size < header.header_size + 1) {
+      return false;
+    }
+    header.streams = data[header.header_size++];
+    if(header.streams != 1 && header.streams != DECODE_STREAMS) {
+      return false;
+    }
+    if(size < header.header_size + 8 * (header.streams - 1)) {
+      return false;
+    }
+    // stream s holds symbols s, s + streams, ..., so each stream's bits must
+    // fit its own symbol count; that bounds every size read from the header
+    uint64_t bits_left = header.bit_count;
+    header.payload_size = 0;
+    for(unsigned s = 0; s < header.streams; s++) {
+      uint64_t bits = bits_left;
+      if(s + 1 < header.streams) {
+        bits = get_le(data + header.header_size, 8);
+        header.header_size += 8;
+        if(bits > bits_left) {
+          return false;
+        }
+      }
+      uint64_t symbols = header.raw_size / header.streams + (s < header.raw_size % header.streams);
+      if(!fits_code_lengths(symbols, bits)) {
+        return false;
+      }
+      header.stream_bits[s] = bits;
+      bits_left -= bits;
+      header.payload_size += (bits + 7) / 8;
+    }
+    return true;
+  }
+
+  bool BlockDecompressor::decode_block(const BlockHeader & header, const unsigned char* payload, unsigned char* out) {
+    HuffmanDecoder decoder;
+    return decode_block(header, payload, out, decoder);
+  }
+
+  bool BlockDecompressor::decode_block(const BlockHeader & header, const unsigned char* payload, unsigned char* out,
+    HuffmanDecoder & decoder) {
+    if(!decoder.build(header.codes)) {
+      return false;
+    }
+
+    // the block must decode to exactly its raw size using exactly its bits
+    if(header.streams == 1) {
+      BitReader reader(payload, header.payload_size);
+      size_t written = 0;
+      if(!decoder.decode(reader, header.bit_count, out, header.raw_size, written)) {
+        return false;
+      }
+      return written == header.raw_size && reader.consumed() == header.bit_count;
+    }
+
+    const unsigned char* starts[DECODE_STREAMS + 1] = { payload };
+    for(unsigned s = 0; s < DECODE_STREAMS; s++) {
+      starts[s + 1] = starts[s] + (header.stream_bits[s] + 7) / 8;
+    }
+    BitReader readers[DECODE_STREAMS] = {
+      BitReader(starts[0], starts[1] - starts[0]), BitReader(starts[1], starts[2] - starts[1]),
+      BitReader(starts[2], starts[3] - starts[2]), BitReader(starts[3], starts[4] - starts[3])
+    };
+    if(!decoder.decode_interleaved(readers, header.stream_bits, out, header.raw_size)) {
+      return false;
+    }
+    for(unsigned s = 0; s < DECODE_STREAMS; s++) {
+      if(readers[s].consumed() != header.stream_bits[s]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool BlockDecompressor::read_table(const unsigned char* data, size_t size, vector<BlockEntry> & table) {
+    if(size < 5 + FOOTER_SIZE || !equal(data, data + 4, BLOCK_MAGIC) || data[4] != BLOCK_VERSION) {
+      return false;
+    }
+
+    const unsigned char* footer = data + size - FOOTER_SIZE;
+    if(!equal(footer + 24, footer + 28, TABLE_MAGIC)) {
+      return false;
+    }
+    uint64_t block_count = get_le(footer, 8);
+    uint64_t table_offset = get_le(footer + 8, 8);
+    uint64_t interval = get_le(footer + 16, 8);
+    if(interval % DECODE_STREAMS != 0) {
+      return false;
+    }
+    if(table_offset > size - FOOTER_SIZE || block_count > (size - FOOTER_SIZE - table_offset) / TABLE_ENTRY_SIZE) {
+      return false;
+    }
+
+    // raw offsets are the running total of the raw sizes. Each entry must
+    // match its block's own sizes, and the blocks' bits must follow one
+    // another before the table, so the total is bounded by the container's
+    // length before anyone sizes an output from it
+    table.clear();
+    uint64_t raw_offset = 0;
+    uint64_t blocks_end = 5;
+    for(uint64_t i = 0; i < block_count; i++) {
+      const unsigned char* entry = data + table_offset + i * TABLE_ENTRY_SIZE;
+      BlockEntry block = { get_le(entry, 8), raw_offset, get_le(entry + 8, 8), get_le(entry + 16, 8), interval };
+      if(block.offset < blocks_end || block.offset > table_offset || table_offset - block.offset < BLOCK_FIELDS_SIZE ||
+        block.checkpoints > size - FOOTER_SIZE) {
+        return false;
+      }
+      uint64_t bit_count = get_le(data + block.offset + 8, 8);
+      uint64_t payload_size = bit_count / 8 + (bit_count % 8 != 0);
+      if(get_le(data + block.offset, 8) != block.raw_size || !fits_code_lengths(block.raw_size, bit_count) ||
+        payload_size > table_offset - block.offset - BLOCK_FIELDS_SIZE ||
+        block.raw_size > UINT64_MAX - raw_offset) {
+        return false;
+      }
+      blocks_end = block.offset + BLOCK_FIELDS_SIZE + payload_size;
+      table.push_back(block);
+      raw_offset += block.raw_size;
+    }
+    return true;
+  }
+
+  bool BlockDecompressor::decompress(const unsigned char* data, size_t size, vector<unsigned char> & out) const {
+    vector<BlockEntry> table;
+    if(!read_table(data, size, table)) {
+      return false;
+    }
+
+    uint64_t raw_size = table.empty() ? 0 : table.back().raw_offset + table.back().raw_size;
+    out.resize(raw_size);
+
+    // every block knows where its output goes, so they can be decoded in any order
+    ThreadPool pool(threads);
+    vector<future<bool>> results;
+    unsigned char* output = out.data();
+    for(auto& block : table) {
+      BlockEntry entry = block;
+      results.push_back(pool.submit([data, size, output, entry]() {
+        BlockHeader header;
+        if(!read_header(data + entry.offset, size - entry.offset, header) || header.raw_size != entry.raw_size ||
+          header.payload_size > size - entry.offset - header.header_size) {
+          return false;
+        }
+        return decode_block(header, data + entry.offset + header.header_size, output + entry.raw_offset);
+      }));
+    }
+
+    bool ok = true;
+    for(auto& result : results) {
+      ok = result.get() && ok;
+    }
+    return ok;
+  }
+
+  bool BlockDecompressor::decompress(istream & in, ostream & out) const {
+    unsigned char magic[5];
+    if(!in.read((char*)magic, 5) || !equal(magic, magic + 4, BLOCK_MAGIC) || magic[4] != BLOCK_VERSION) {
+      return false;
+    }
+
+    vector<unsigned char> header_bytes, payload, decoded;
+    for(;;) {
+      // fixed fields, then the letter count, then the (letter, length) pairs
+      header_bytes.resize(BLOCK_FIELDS_SIZE + 1);
+      if(!in.read((char*)header_bytes.data(), 8)) {
+        return false;
+      }
+      if(get_le(header_bytes.data(), 8) == 0) {
+        return true;
+      }
+      if(!in.read((char*)&header_bytes[8], BLOCK_FIELDS_SIZE - 8 + 1)) {
+        return false;
+      }
+      size_t pairs = 2 * (size_t(header_bytes[BLOCK_FIELDS_SIZE]) + 1);
+      size_t read = BLOCK_FIELDS_SIZE + 1;
+      header_bytes.resize(read + pairs + 1);
+      if(!in.read((char*)&header_bytes[read], pairs + 1)) {
+        return false;
+      }
+
+      // then the stream count and all but the last stream's bit count
+      read += pairs + 1;
+      size_t stream_fields = header_bytes[read - 1] > 1 ? 8 * (size_t(header_bytes[read - 1]) - 1) : 0;
+      header_bytes.resize(read + stream_fields);
+      if(!in.read((char*)&header_bytes[read], stream_fields)) {
+        return false;
+      }
+
+      BlockHeader header;
+      if(!read_header(header_bytes.data(), header_bytes.size(), header)) {
+        return false;
+      }
+
+      // the sizes only agree with each other, so the payload is read a chunk
+      // at a time and a stream that ends early is found before much is allocated
+      payload.clear();
+      while(payload.size() < header.payload_size) {
+        size_t read = payload.size();
+        payload.resize(read + min(uint64_t(STREAM_CHUNK_SIZE), header.payload_size - read));
+        if(!in.read((char*)&payload[read], payload.size() - read)) {
+          return false;
+        }
+      }
+      decoded.resize(header.raw_size);
+      if(!decode_block(header, payload.data(), decoded.data())) {
+        return false;
+      }
+      out.write((const char*)decoded.data(), decoded.size());
+    }
+  }
+
+  bool BlockDecompressor::decode_range(const unsigned char* data, size_t size, uint64_t offset, uint64_t length,
+    vector<unsigned char> & out) {
+    vector<BlockEntry> table;
+    if(!read_table(data, size, table)) {
+      return false;
+    }
+    uint64_t raw_size = table.empty() ? 0 : table.back().raw_offset + table.back().raw_size;
+    if(offset > raw_size || length > raw_size - offset) {
+      return false;
+    }
+    out.resize(length);
+
+    // first block holding part of the range
+    size_t b = upper_bound(table.begin(), table.end(), offset, [](uint64_t value, const BlockEntry & entry) {
+      return value < entry.raw_offset;
+    }) - table.begin();
+    b = b == 0 ? 0 : b - 1;
+
+    vector<unsigned char> decoded;
+    for(uint64_t done = 0; done < length; b++) {
+      const BlockEntry & entry = table[b];
+      BlockHeader header;
+      if(!read_header(data + entry.offset, size - entry.offset, header) || header.raw_size != entry.raw_size ||
+        header.payload_size > size - entry.offset - header.header_size) {
+        return false;
+      }
+      HuffmanDecoder decoder;
+      if(!decoder.build(header.codes)) {
+        return false;
+      }
+
+      // the range within this block, and the last checkpoint at or before its start
+      uint64_t first = offset + done - entry.raw_offset;
+      uint64_t last = min(entry.raw_size, first + (length - done));
+      uint64_t k = entry.interval != 0 ? first / entry.interval : 0;
+      uint64_t start = k * entry.interval;
+      size_t streams = header.streams;
+      if(k > 0 && (k * streams * 8 > size - FOOTER_SIZE - entry.checkpoints || start >= entry.raw_size)) {
+        return false;
+      }
+
+      // a reader per stream, positioned at the checkpoint's bit offset
+      vector<BitReader> readers;
+      // bits each reader has from its starting byte on
+      uint64_t bits_left[DECODE_STREAMS] = {0};
+      const unsigned char* payload = data + entry.offset + header.header_size;
+      for(size_t s = 0; s < streams; s++) {
+        uint64_t stream_bytes = (header.stream_bits[s] + 7) / 8;
+        uint64_t bit = k > 0 ? get_le(data + entry.checkpoints + ((k - 1) * streams + s) * 8, 8) : 0;
+        if(bit > header.stream_bits[s]) {
+          return false;
+        }
+        readers.push_back(BitReader(payload + bit / 8, stream_bytes - bit / 8));
+        readers.back().refill();
+        readers.back().consume(bit % 8);
+        bits_left[s] = header.stream_bits[s] - bit / 8 * 8;
+        payload += stream_bytes;
+      }
+
+      decoded.resize(last - start);
+      if(streams == 1) {
+        size_t written = 0;
+        if(!decoder.decode(readers[0], bits_left[0], decoded.data(), decoded.size(), written) ||
+          written != decoded.size()) {
+          return false;
+        }
+      } else if(!decoder.decode_interleaved(readers.data(), bits_left, decoded.data(), decoded.size())) {
+        return false;
+      }
+
+      copy(decoded.begin() + (first - start), decoded.end(), out.begin() + done);
+      done += last - first;
+    }
+    return true;
+  }
+}
@@ -0,0 +1,207 @@
+// Huffman Code Table class definitions
+
+#include "huffmancodetable.h"
+#include "huffmanbits.h"
+#include <cstddef>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace YNGMAT005 {
+
+  HuffmanCodeTable::HuffmanCodeTable() {
+    this->clear();
+  }
+
+  void HuffmanCodeTable::clear() {
+    for(int i = 0; i < 256; i++) {
+      codes[i].bits = 0;
+      codes[i].length = 0;
+    }
+  }
+
+  void HuffmanCodeTable::set(unsigned char letter, uint64_t bits, unsigned char length) {
+    codes[letter].bits = bits;
+    codes[letter].length = length;
+  }
+
+  bool HuffmanCodeTable::assign_canonical(const unsigned char* lengths) {
+    // count the codes of each length and check they fit in a prefix code
+    uint64_t length_count[MAX_CODE_LENGTH + 1] = {0};
+    uint64_t kraft = 0;
+    for(int i = 0; i < 256; i++) {
+      if(lengths[i] > MAX_CODE_LENGTH) {
+        return false;
+      }
+      if(lengths[i] != 0) {
+        length_count[lengths[i]]++;
+        kraft += uint64_t(1) << (MAX_CODE_LENGTH - lengths[i]);
+      }
+    }
+    if(kraft > uint64_t(1) << MAX_CODE_LENGTH) {
+      return false;
+    }
+
+    // first code of each length follows on from the codes one bit shorter
+    uint64_t next_code[MAX_CODE_LENGTH + 1] = {0};
+    uint64_t code = 0;
+    for(unsigned len = 1; len <= MAX_CODE_LENGTH; len++) {
+      code = (code + length_count[len - 1]) << 1;
+      next_code[len] = code;
+    }
+
+    // hand out consecutive codes to letters of each length in byte order
+    for(int i = 0; i < 256; i++) {
+      codes[i].length = lengths[i];
+      codes[i].bits = lengths[i] != 0 ? next_code[lengths[i]]++ : 0;
+    }
+    return true;
+  }
+
+  bool HuffmanCodeTable::build(const unsigned char* lengths, const uint64_t* frequencies, unsigned max_length) {
+    unsigned limit = max_length != 0 ? min(max_length, MAX_CODE_LENGTH) : MAX_CODE_LENGTH;
+    if(*max_element(lengths, lengths + 256) > limit) {
+      return this->build_limited(frequencies, limit);
+    }
+    return this->assign_canonical(lengths);
+  }
+
+  bool HuffmanCodeTable::build_limited(const uint64_t* frequencies, unsigned max_length) {
+    // used letters, lightest first
+    vector<pair<uint64_t, int>> letters;
+    for(int i = 0; i < 256; i++) {
+      if(frequencies[i] != 0) {
+        letters.push_back(pair<uint64_t, int>(frequencies[i], i));
+      }
+    }
+    sort(letters.begin(), letters.end());
+
+    size_t n = letters.size();
+    unsigned char lengths[256] = {0};
+    if(n == 0) {
+      return false;
+    }
+    if(n == 1) {
+      lengths[letters[0].second] = 1;
+      return this->assign_canonical(lengths);
+    }
+
+    // never ask for fewer bits than it takes to give every letter a code
+    unsigned shortest = 1;
+    while((size_t(1) << shortest) < n) {
+      shortest++;
+    }
+    max_length = min(max(max_length, shortest), MAX_CODE_LENGTH);
+
+    // items are leaves (letter >= 0) or packages of two earlier items
+    struct Item {
+      uint64_t weight;
+      int letter;
+      int left, right;
+    };
+    vector<Item> items;
+    vector<int> leaves, current, packages, merged;
+    for(auto& x : letters) {
+      Item leaf = { x.first, x.second, -1, -1 };
+      leaves.push_back(items.size());
+      items.push_back(leaf);
+    }
+
+    // package the list pairwise and merge the packages back in with the
+    // leaves, once per extra bit of code length allowed
+    current = leaves;
+    for(unsigned level = 1; level < max_length; level++) {
+      packages.clear();
+      for(size_t i = 0; i + 1 < current.size(); i += 2) {
+        Item package = { items[current[i]].weight + items[current[i + 1]].weight, -1, current[i], current[i + 1] };
+        packages.push_back(items.size());
+        items.push_back(package);
+      }
+
+      merged.clear();
+      size_t a = 0, b = 0;
+      while(a < leaves.size() || b < packages.size()) {
+        if(b == packages.size() || (a < leaves.size() && items[leaves[a]].weight <= items[packages[b]].weight)) {
+          merged.push_back(leaves[a++]);
+        } else {
+          merged.push_back(packages[b++]);
+        }
+      }
+      current.swap(merged);
+    }
+
+    // each time a letter appears in the cheapest 2n - 2 items adds a bit to its code
+    vector<int> stack(current.begin(), current.begin() + (2 * n - 2));
+    while(!stack.empty()) {
+      const Item & item = items[stack.back()];
+      stack.pop_back();
+      if(item.letter >= 0) {
+        lengths[item.letter]++;
+      } else {
+        stack.push_back(item.left);
+        stack.push_back(item.right);
+      }
+    }
+    return this->assign_canonical(lengths);
+  }
+
+  void HuffmanCodeTable::serialize(vector<unsigned char> & out) const {
+    // letter count - 1, then (letter, length) pairs
+    unsigned count = this->size();
+    out.push_back(count == 0 ? 0 : count - 1);
+    for(int i = 0; i < 256; i++) {
+      if(codes[i].length != 0) {
+        out.push_back(i);
+        out.push_back(codes[i].length);
+      }
+    }
+  }
+
+  bool HuffmanCodeTable::deserialize(const unsigned char* data, size_t size, size_t & used) {
+    if(size < 1) {
+      return false;
+    }
+
+    size_t count = size_t(data[0]) + 1;
+    if(size < 1 + 2 * count) {
+      return false;
+    }
+
+    unsigned char lengths[256] = {0};
+    for(size_t i = 0; i < count; i++) {
+      unsigned char letter = data[1 + 2 * i];
+      unsigned char length = data[2 + 2 * i];
+      // each letter once, with a usable length
+      if(lengths[letter] != 0 || length == 0) {
+        return false;
+      }
+      lengths[letter] = length;
+    }
+
+    if(!this->assign_canonical(lengths)) {
+      return false;
+    }
+    used = 1 + 2 * count;
+    return true;
+  }
+
+  unsigned HuffmanCodeTable::size() const {
+    unsigned count = 0;
+    for(int i = 0; i < 256; i++) {
+      count += codes[i].length != 0;
+    }
+    return count;
+  }
+
+  string HuffmanCodeTable::bit_string(unsigned char letter) const {
+    string bits;
+    for(int b = codes[letter].length - 1; b >= 0; b--) {
+      bits += (codes[letter].bits >> b) & 1 ? '1' : '0';
+    }
+    return bits;
+  }
+}
@@ -0,0 +1,68 @@
+// Huffman Codec class definitions
+
+#include "huffmancodec.h"
+#include "huffmanbits.h"
+#include "huffmanblock.h"
+#include "huffmandecoder.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+namespace YNGMAT005 {
+
+  HuffmanCodec::HuffmanCodec() {
+    max_code_length = 0;
+  }
+
+  void HuffmanCodec::set_max_code_length(unsigned length) {
+    max_code_length = length;
+  }
+
+  void HuffmanCodec::reset() {
+    arena.clear();
+    decoder.clear();
+    checkpoints.clear();
+  }
+
+  vector<unsigned char> HuffmanCodec::compress(const unsigned char* data, size_t size) {
+    vector<unsigned char> frame;
+    this->compress(data, size, frame);
+    return frame;
+  }
+
+  void HuffmanCodec::compress(const unsigned char* data, size_t size, vector<unsigned char> & out) {
+    out.clear();
+    if(size == 0) {
+      put_le(out, 0, 8);
+      return;
+    }
+
+    // one block covering the whole buffer; checkpoints are only kept in containers
+    BlockCompressor compressor(size, 1);
+    compressor.set_max_code_length(max_code_length);
+    compressor.set_streams(size < INTERLEAVE_MIN_SIZE ? 1 : DECODE_STREAMS);
+    compressor.set_checkpoint_interval(0);
+    compressor.encode_block(data, size, out, checkpoints, arena);
+  }
+
+  bool HuffmanCodec::decompress(const unsigned char* data, size_t size, vector<unsigned char> & out) {
+    out.clear();
+    if(size >= 8 && get_le(data, 8) == 0) {
+      return size == 8;
+    }
+
+    // read_header holds the sizes to each other; they must also fill the buffer exactly
+    BlockHeader header;
+    if(!BlockDecompressor::read_header(data, size, header) || header.header_size + header.payload_size != size) {
+      return false;
+    }
+    out.resize(header.raw_size);
+    if(!BlockDecompressor::decode_block(header, data + header.header_size, out.data(), decoder)) {
+      out.clear();
+      return false;
+    }
+    return true;
+  }
+}
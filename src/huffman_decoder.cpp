@@ -0,0 +1,233 @@
+// Huffman Decoder class definitions
+
+#include "huffmandecoder.h"
+#include "huffmanbits.h"
+#include "huffmancodetable.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace YNGMAT005 {
+
+  HuffmanDecoder::HuffmanDecoder() {
+    root_bits = 0;
+    max_length = 0;
+  }
+
+  bool HuffmanDecoder::build(const uint64_t* codes, const unsigned char* lengths, unsigned num_symbols) {
+    this->clear();
+
+    // left-align every code so that sorting groups codes by shared prefix
+    sorted.clear();
+    uint64_t kraft = 0;
+    for(unsigned s = 0; s < num_symbols; s++) {
+      if(lengths[s] == 0) {
+        continue;
+      }
+      if(lengths[s] > MAX_CODE_LENGTH || codes[s] >> lengths[s] != 0) {
+        return false;
+      }
+      sorted.push_back(pair<uint64_t, uint16_t>(codes[s] << (64 - lengths[s]), s));
+      kraft += uint64_t(1) << (MAX_CODE_LENGTH - lengths[s]);
+      max_length = max(max_length, unsigned(lengths[s]));
+    }
+
+    // no symbols, or more codes than a prefix code can hold
+    if(sorted.empty() || kraft > uint64_t(1) << MAX_CODE_LENGTH) {
+      max_length = 0;
+      return false;
+    }
+
+    sort(sorted.begin(), sorted.end());
+    root_bits = min(DECODE_TABLE_BITS, max_length);
+    table.resize(size_t(1) << root_bits);
+
+    if(!this->fill(0, root_bits, 0, sorted, lengths, 0, sorted.size())) {
+      table.clear();
+      max_length = 0;
+      return false;
+    }
+    return true;
+  }
+
+  bool HuffmanDecoder::build(const HuffmanCodeTable & codes) {
+    uint64_t bits[256];
+    unsigned char lengths[256];
+    for(int i = 0; i < 256; i++) {
+      bits[i] = codes.get(i).bits;
+      lengths[i] = codes.get(i).length;
+    }
+    return this->build(bits, lengths, 256);
+  }
+
+  void HuffmanDecoder::clear() {
+    table.clear();
+    max_length = 0;
+  }
+
+  bool HuffmanDecoder::fill(uint32_t base, unsigned bits, unsigned depth, vector<pair<uint64_t, uint16_t>> & codes,
+    const unsigned char* lengths, size_t first, size_t last) {
+    size_t i = first;
+
+    while(i < last) {
+      uint64_t index = (codes[i].first << depth) >> (64 - bits);
+      unsigned length = lengths[codes[i].second];
+
+      if(length <= depth + bits) {
+        // short enough to resolve here - replicate the leaf across every
+        // slot whose leading bits match the code
+        size_t span = size_t(1) << (depth + bits - length);
+        for(size_t k = 0; k < span; k++) {
+          DecodeEntry & entry = table[base + index + k];
+          // an occupied slot means the codes are not prefix free
+          if(entry.length != 0 || entry.bits != 0) {
+            return false;
+          }
+          entry.symbol = codes[i].second;
+          entry.length = length;
+        }
+        i++;
+      } else {
+        // gather all longer codes sharing this slot's prefix into a subtable
+        size_t j = i;
+        unsigned longest = length;
+        while(j < last && (codes[j].first << depth) >> (64 - bits) == index) {
+          longest = max(longest, unsigned(lengths[codes[j].second]));
+          j++;
+        }
+
+        unsigned sub_bits = min(longest - depth - bits, DECODE_TABLE_BITS);
+        uint32_t sub_base = table.size();
+        table.resize(table.size() + (size_t(1) << sub_bits));
+        table[base + index].bits = sub_bits;
+        table[base + index].next = sub_base;
+
+        if(!this->fill(sub_base, sub_bits, depth + bits, codes, lengths, i, j)) {
+          return false;
+        }
+        i = j;
+      }
+    }
+    return true;
+  }
+
+  bool HuffmanDecoder::decode(BitReader & reader, uint64_t bit_count, unsigned char* out, size_t capacity,
+    size_t & written) const {
+    written = 0;
+    if(table.empty()) {
+      return bit_count == 0;
+    }
+
+    while(reader.consumed() < bit_count && written < capacity) {
+      reader.refill();
+
+      // the register holds at least max_length bits after a refill, so keep
+      // decoding from it until it runs low
+      while(reader.available() >= max_length && reader.consumed() < bit_count && written < capacity) {
+        int symbol = this->next_symbol(reader);
+        if(symbol < 0) {
+          return false;
+        }
+        out[written++] = symbol;
+      }
+    }
+
+    // a code running past the end of the stream means the data is corrupt
+    return reader.consumed() <= bit_count;
+  }
+
+  bool HuffmanDecoder::decode(BitReader & reader, uint64_t bit_count, string & out) const {
+    unsigned char buffer[DECODE_BUFFER_SIZE];
+    size_t written = 0;
+
+    while(reader.consumed() < bit_count) {
+      if(!this->decode(reader, bit_count, buffer, DECODE_BUFFER_SIZE, written)) {
+        return false;
+      }
+      out.append((const char*)buffer, written);
+    }
+    return reader.consumed() == bit_count;
+  }
+
+  bool HuffmanDecoder::decode(BitReader & reader, uint64_t bit_count, ostream & out) const {
+    unsigned char buffer[DECODE_BUFFER_SIZE];
+    size_t written = 0;
+
+    while(reader.consumed() < bit_count) {
+      if(!this->decode(reader, bit_count, buffer, DECODE_BUFFER_SIZE, written)) {
+        return false;
+      }
+      out.write((const char*)buffer, written);
+    }
+    return reader.consumed() == bit_count && out.good();
+  }
+
+  bool HuffmanDecoder::decode_interleaved(BitReader* readers, const uint64_t* bit_counts, unsigned char* out,
+    size_t size) const {
+    if(table.empty()) {
+      return size == 0;
+    }
+
+    // a refill leaves at least MAX_CODE_LENGTH bits in each register, enough
+    // for this many codes before the next refill
+    size_t groups = size / DECODE_STREAMS;
+    size_t rounds = MAX_CODE_LENGTH / max_length;
+    size_t group = 0;
+
+    while(group < groups) {
+      readers[0].refill();
+      readers[1].refill();
+      readers[2].refill();
+      readers[3].refill();
+
+      size_t last = min(groups, group + rounds);
+      for(; group < last; group++) {
+        int a = this->next_symbol(readers[0]);
+        int b = this->next_symbol(readers[1]);
+        int c = this->next_symbol(readers[2]);
+        int d = this->next_symbol(readers[3]);
+        if((a | b | c | d) < 0) {
+          return false;
+        }
+        unsigned char* slot = out + group * DECODE_STREAMS;
+        slot[0] = a;
+        slot[1] = b;
+        slot[2] = c;
+        slot[3] = d;
+      }
+
+      // a round reads no further than one register past a stream's end, so
+      // running out of bits is caught before the next round decodes from zeros
+      if(readers[0].consumed() > bit_counts[0] || readers[1].consumed() > bit_counts[1] ||
+        readers[2].consumed() > bit_counts[2] || readers[3].consumed() > bit_counts[3]) {
+        return false;
+      }
+    }
+
+    // the symbols left over after the last full group
+    for(size_t i = groups * DECODE_STREAMS; i < size; i++) {
+      BitReader & reader = readers[i % DECODE_STREAMS];
+      reader.refill();
+      int symbol = this->next_symbol(reader);
+      if(symbol < 0 || reader.consumed() > bit_counts[i % DECODE_STREAMS]) {
+        return false;
+      }
+      out[i] = symbol;
+    }
+    return true;
+  }
+
+  bool HuffmanDecoder::is_built() const {
+    return !table.empty();
+  }
+
+  size_t HuffmanDecoder::table_size() const {
+    return table.size();
+  }
+}
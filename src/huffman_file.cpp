@@ -0,0 +1,41 @@
+// Compressed file header definitions
+
+#include "huffmanfile.h"
+#include "huffmanbits.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+namespace YNGMAT005 {
+
+  void write_file_header(vector<unsigned char> & out, const FileHeader & header) {
+    out.insert(out.end(), FILE_MAGIC, FILE_MAGIC + 4);
+    out.push_back(FILE_VERSION);
+    out.push_back(0);
+    put_le(out, header.table_size, 2);
+    put_le(out, header.raw_size, 8);
+    put_le(out, header.bit_count, 8);
+  }
+
+  bool read_file_header(const unsigned char* data, uint64_t file_size, FileHeader & header) {
+    if(file_size < FILE_HEADER_SIZE || !equal(data, data + 4, FILE_MAGIC) || data[4] != FILE_VERSION) {
+      return false;
+    }
+    header.table_size = get_le(data + 6, 2);
+    header.raw_size = get_le(data + 8, 8);
+    header.bit_count = get_le(data + 16, 8);
+
+    if(header.table_size < 3 || header.table_size > MAX_TABLE_SIZE ||
+      !fits_code_lengths(header.raw_size, header.bit_count)) {
+      return false;
+    }
+
+    // the table and the packed bits must fill the rest of the file exactly
+    uint64_t payload_size = header.bit_count / 8 + (header.bit_count % 8 != 0);
+    return file_size - FILE_HEADER_SIZE >= header.table_size &&
+      file_size - FILE_HEADER_SIZE - header.table_size == payload_size;
+  }
+
+}
@@ -0,0 +1,104 @@
+// Byte histogram definitions
+
+#include "huffmanhistogram.h"
+#include "huffmanthreadpool.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <vector>
+
+using namespace std;
+
+namespace YNGMAT005 {
+
+  void count_bytes(const unsigned char* data, size_t size, uint64_t* histogram) {
+    uint32_t tables[4][256];
+
+    while(size > 0) {
+      size_t chunk = min(size, HISTOGRAM_CHUNK_SIZE);
+      memset(tables, 0, sizeof(tables));
+
+      // two bytes per table from every word
+      size_t i = 0;
+      for(; i + 8 <= chunk; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        tables[0][word & 0xFF]++;
+        tables[1][(word >> 8) & 0xFF]++;
+        tables[2][(word >> 16) & 0xFF]++;
+        tables[3][(word >> 24) & 0xFF]++;
+        tables[0][(word >> 32) & 0xFF]++;
+        tables[1][(word >> 40) & 0xFF]++;
+        tables[2][(word >> 48) & 0xFF]++;
+        tables[3][word >> 56]++;
+      }
+
+      // leftover bytes at the end of the chunk
+      for(; i < chunk; i++) {
+        tables[0][data[i]]++;
+      }
+
+      for(int b = 0; b < 256; b++) {
+        histogram[b] += uint64_t(tables[0][b]) + tables[1][b] + tables[2][b] + tables[3][b];
+      }
+
+      data += chunk;
+      size -= chunk;
+    }
+  }
+
+  void count_bytes(const unsigned char* data, size_t size, uint64_t* histogram, ThreadPool & pool) {
+    size_t slices = min(size_t(pool.size()), size / PARALLEL_SLICE_SIZE);
+    if(slices <= 1) {
+      count_bytes(data, size, histogram);
+      return;
+    }
+
+    // each thread counts its own slice into its own table
+    size_t slice_size = size / slices;
+    vector<future<array<uint64_t, 256>>> counts;
+    for(size_t s = 0; s < slices; s++) {
+      const unsigned char* start = data + s * slice_size;
+      size_t length = s + 1 == slices ? size - s * slice_size : slice_size;
+      counts.push_back(pool.submit([start, length]() {
+        array<uint64_t, 256> table;
+        table.fill(0);
+        count_bytes(start, length, table.data());
+        return table;
+      }));
+    }
+
+    // reduce the per-thread tables
+    for(auto& count : counts) {
+      array<uint64_t, 256> table = count.get();
+      for(int b = 0; b < 256; b++) {
+        histogram[b] += table[b];
+      }
+    }
+  }
+
+  void floor_counts(uint64_t* histogram) {
+    for(int i = 0; i < 256; i++) {
+      histogram[i] = max(histogram[i], COUNT_FLOOR);
+    }
+  }
+
+  size_t sample_bytes(const unsigned char* data, size_t size, uint64_t* histogram, double fraction) {
+    // not worth sampling unless it skips at least half the input
+    size_t blocks = size_t(size * fraction / SAMPLE_BLOCK_SIZE);
+    if(fraction <= 0 || blocks == 0 || blocks * SAMPLE_BLOCK_SIZE * 2 > size) {
+      count_bytes(data, size, histogram);
+      return size;
+    }
+
+    // one block from the start of each stride, so the sample spans the input
+    size_t stride = size / blocks;
+    for(size_t k = 0; k < blocks; k++) {
+      count_bytes(data + k * stride, SAMPLE_BLOCK_SIZE, histogram);
+    }
+    return blocks * SAMPLE_BLOCK_SIZE;
+  }
+}
@@ -0,0 +1,141 @@
+// Mapped File class definitions
+
+#include "huffmanmappedfile.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace YNGMAT005 {
+
+  MappedFile::MappedFile() {
+    view = nullptr;
+    length = 0;
+    mapped = false;
+    opened = false;
+  }
+
+  MappedFile::~MappedFile() {
+    this->close();
+  }
+
+  bool MappedFile::open(const string & path, bool sequential) {
+    this->close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+      return false;
+    }
+
+    // map regular files; empty files have nothing to map
+    struct stat info;
+    if(fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+      void* address = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if(address != MAP_FAILED) {
+        madvise(address, info.st_size, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+        view = (const unsigned char*)address;
+        length = info.st_size;
+        mapped = true;
+        opened = true;
+      }
+    }
+
+    // fall back to reading the file in
+    if(!mapped) {
+      opened = this->read_all(fd);
+    }
+    ::close(fd);
+    return opened;
+  }
+
+  bool MappedFile::read_all(int fd) {
+    const size_t chunk = size_t(1) << 20;
+    buffer.clear();
+    for(;;) {
+      size_t offset = buffer.size();
+      buffer.resize(offset + chunk);
+      ssize_t read = ::read(fd, &buffer[offset], chunk);
+      if(read < 0 && errno == EINTR) {
+        buffer.resize(offset);
+        continue;
+      }
+      if(read <= 0) {
+        buffer.resize(offset);
+        if(read < 0) {
+          buffer.clear();
+          return false;
+        }
+        break;
+      }
+      buffer.resize(offset + read);
+    }
+
+    view = buffer.data();
+    length = buffer.size();
+    return true;
+  }
+
+  void MappedFile::close() {
+    if(mapped) {
+      munmap((void*)view, length);
+    }
+    buffer.clear();
+    buffer.shrink_to_fit();
+    view = nullptr;
+    length = 0;
+    mapped = false;
+    opened = false;
+  }
+
+  void MappedFile::advise(bool sequential) {
+    if(mapped) {
+      madvise((void*)view, length, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+    }
+  }
+
+  void MappedFile::release(size_t offset, size_t size) {
+    if(!mapped || offset >= length) {
+      return;
+    }
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t start = offset / page * page;
+    size_t end = offset + min(size, length - offset);
+    end = end == length ? length : end / page * page;
+    if(end > start) {
+      madvise((void*)(view + start), end - start, MADV_DONTNEED);
+    }
+  }
+
+  void MappedFile::detach() {
+    if(!mapped) {
+      return;
+    }
+    buffer.assign(view, view + length);
+    munmap((void*)view, length);
+    view = buffer.data();
+    mapped = false;
+  }
+
+  const unsigned char* MappedFile::data() const {
+    return view;
+  }
+
+  size_t MappedFile::size() const {
+    return length;
+  }
+
+  bool MappedFile::is_open() const {
+    return opened;
+  }
+
+  bool MappedFile::is_mapped() const {
+    return mapped;
+  }
+}
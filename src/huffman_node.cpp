@@ -1,5 +1,6 @@
 // Huffman Node class definitions
 
+#include <cstdint>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -9,7 +10,7 @@ using namespace std;
 
 namespace YNGMAT005 {
 
-	HuffmanNode::HuffmanNode(string l, int freq) {
+	HuffmanNode::HuffmanNode(string l, uint64_t freq) {
 		letter = l;
 		frequency = freq;
 	}
@@ -45,7 +46,7 @@ namespace YNGMAT005 {
 		return letter;
 	}
 
-	int HuffmanNode::get_frequency() {
+	uint64_t HuffmanNode::get_frequency() {
 		return frequency;
 	}
 }
\ No newline at end of file
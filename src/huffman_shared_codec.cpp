@@ -0,0 +1,123 @@
+// Huffman Shared Codec class definitions
+
+#include "huffmansharedcodec.h"
+#include "huffmanarena.h"
+#include "huffmanbits.h"
+#include "huffmancodetable.h"
+#include "huffmandecoder.h"
+#include "huffmanhistogram.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+namespace YNGMAT005 {
+
+  HuffmanSharedCodec::HuffmanSharedCodec() {
+    fill(samples, samples + 256, 0);
+    max_code_length = DEFAULT_SHARED_CODE_LENGTH;
+    longest = 0;
+  }
+
+  void HuffmanSharedCodec::set_max_code_length(unsigned length) {
+    max_code_length = length;
+  }
+
+  void HuffmanSharedCodec::add_sample(const unsigned char* data, size_t size) {
+    count_bytes(data, size, samples);
+  }
+
+  bool HuffmanSharedCodec::train() {
+    uint64_t frequencies[256];
+    copy(samples, samples + 256, frequencies);
+    floor_counts(frequencies);
+
+    // optimal lengths from the tree, unless they run past the limit
+    HuffmanArena arena;
+    arena.build(frequencies);
+    unsigned char lengths[256] = {0};
+    arena.code_lengths(lengths);
+    return codes.build(lengths, frequencies, max_code_length) && this->prepare();
+  }
+
+  bool HuffmanSharedCodec::prepare() {
+    longest = 0;
+    for(int i = 0; i < 256; i++) {
+      longest = max(longest, unsigned(codes.get(i).length));
+    }
+    return decoder.build(codes);
+  }
+
+  void HuffmanSharedCodec::serialize(vector<unsigned char> & out) const {
+    codes.serialize(out);
+  }
+
+  bool HuffmanSharedCodec::load(const unsigned char* data, size_t size, size_t & used) {
+    if(!codes.deserialize(data, size, used) || !this->prepare()) {
+      codes.clear();
+      decoder.clear();
+      longest = 0;
+      return false;
+    }
+    return true;
+  }
+
+  bool HuffmanSharedCodec::is_ready() const {
+    return decoder.is_built();
+  }
+
+  const HuffmanCodeTable & HuffmanSharedCodec::get_codes() const {
+    return codes;
+  }
+
+  bool HuffmanSharedCodec::compress(const unsigned char* data, size_t size, vector<unsigned char> & out) const {
+    out.clear();
+    if(!this->is_ready()) {
+      return false;
+    }
+    put_varint(out, size);
+
+    // room for every byte at the longest code, plus the writer's word stores
+    size_t offset = out.size();
+    out.resize(offset + (size * longest + 7) / 8 + 8);
+    BitWriter writer(&out[offset], out.size() - offset);
+    for(size_t i = 0; i < size; i++) {
+      const HuffmanCode & code = codes.get(data[i]);
+      if(code.length == 0) {
+        out.clear();
+        return false;
+      }
+      writer.write(code.bits, code.length);
+    }
+    writer.flush();
+    out.resize(offset + writer.bytes());
+    return true;
+  }
+
+  bool HuffmanSharedCodec::decompress(const unsigned char* data, size_t size, vector<unsigned char> & out) const {
+    out.clear();
+    uint64_t raw_size = 0;
+    size_t used = 0;
+    if(!this->is_ready() || !get_varint(data, size, raw_size, used)) {
+      return false;
+    }
+
+    uint64_t payload_bits = uint64_t(size - used) * 8;
+    if(!fits_packed_bytes(raw_size, size - used)) {
+      return false;
+    }
+    out.resize(raw_size);
+
+    // decode exactly raw_size bytes; only the last byte's padding may be left over
+    BitReader reader(data + used, size - used);
+    size_t written = 0;
+    if(!decoder.decode(reader, payload_bits, out.data(), out.size(), written) || written != raw_size ||
+      (reader.consumed() + 7) / 8 != size - used) {
+      out.clear();
+      return false;
+    }
+    return true;
+  }
+}
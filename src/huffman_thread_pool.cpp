@@ -0,0 +1,60 @@
+// Thread Pool class definitions
+
+#include "huffmanthreadpool.h"
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+using namespace std;
+
+namespace YNGMAT005 {
+
+  ThreadPool::ThreadPool(unsigned threads) {
+    stopping = false;
+    if(threads == 0) {
+      threads = thread::hardware_concurrency();
+    }
+    if(threads == 0) {
+      threads = 1;
+    }
+
+    for(unsigned i = 0; i < threads; i++) {
+      workers.push_back(thread(&ThreadPool::work, this));
+    }
+  }
+
+  ThreadPool::~ThreadPool() {
+    {
+      lock_guard<mutex> guard(lock);
+      stopping = true;
+    }
+    ready.notify_all();
+
+    for(auto& worker : workers) {
+      worker.join();
+    }
+  }
+
+  void ThreadPool::work() {
+    for(;;) {
+      function<void(void)> task;
+      {
+        unique_lock<mutex> guard(lock);
+        ready.wait(guard, [this]() { return stopping || !tasks.empty(); });
+
+        // only leave once the queue has drained
+        if(tasks.empty()) {
+          return;
+        }
+        task = move(tasks.front());
+        tasks.pop();
+      }
+      task();
+    }
+  }
+
+  unsigned ThreadPool::size() const {
+    return workers.size();
+  }
+}
@@ -2,6 +2,15 @@
 
 #include "huffmantree.h"
 #include "huffmannode.h"
+#include "huffmandecoder.h"
+#include "huffmanbits.h"
+#include "huffmancodetable.h"
+#include "huffmanarena.h"
+#include "huffmanhistogram.h"
+#include "huffmanthreadpool.h"
+#include "huffmanblock.h"
+#include "huffmanmappedfile.h"
+#include "huffmanfile.h"
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -11,7 +20,9 @@
 #include <iostream>
 #include <sstream>
 #include <utility>
-#include <math.h>
+#include <algorithm>
+#include <iterator>
+#include <cstdint>
 
 using namespace std;
 
@@ -19,6 +30,12 @@ namespace YNGMAT005 {
 
   // Default Constructor
   HuffmanTree::HuffmanTree() {
+    input = make_shared<MappedFile>();
+    histogram.fill(0);
+    max_code_length = 0;
+    threads = 1;
+    sample_fraction = 0;
+    sampled = false;
     loaded = false;
     root = nullptr;
   }
@@ -27,6 +44,12 @@ namespace YNGMAT005 {
   HuffmanTree::HuffmanTree(string input_file, string output_file) {
     this->input_file = input_file;
     this->output_file = output_file;
+    this->input = make_shared<MappedFile>();
+    this->histogram.fill(0);
+    this->max_code_length = 0;
+    this->threads = 1;
+    this->sample_fraction = 0;
+    this->sampled = false;
     this->run();
   }
 
@@ -36,12 +59,19 @@ namespace YNGMAT005 {
       root = nullptr;
     }
 
-    nodes = tree.nodes;
-    frequencies = tree.frequencies;
-    code_table = tree.code_table;
-    root = tree.root;
+    arena = tree.arena;
+    histogram = tree.histogram;
+    codes = tree.codes;
+    // share one linked view between both trees
+    root = tree.get_root();
     input_file = tree.input_file;
     output_file = tree.output_file;
+    // the mapping is read-only, so both trees can encode from it
+    input = tree.input;
+    max_code_length = tree.max_code_length;
+    threads = tree.threads;
+    sample_fraction = tree.sample_fraction;
+    sampled = tree.sampled;
     loaded = tree.loaded;
   }
 
@@ -51,12 +81,19 @@ namespace YNGMAT005 {
       root = nullptr;
     }
 
-    nodes = move(tree.nodes);
-    frequencies = move(tree.frequencies);
-    code_table = move(tree.code_table);
+    arena = move(tree.arena);
+    tree.arena.clear();
+    histogram = tree.histogram;
+    codes = tree.codes;
     root = move(tree.root);
     input_file = move(tree.input_file);
     output_file = move(tree.output_file);
+    input = move(tree.input);
+    tree.input = make_shared<MappedFile>();
+    max_code_length = tree.max_code_length;
+    threads = tree.threads;
+    sample_fraction = tree.sample_fraction;
+    sampled = tree.sampled;
     loaded = move(tree.loaded);
   }
 
@@ -73,113 +110,131 @@ namespace YNGMAT005 {
     // the rest of the building operations
     if(loaded) {
       this->build_tree();
-      this->build_code_table(root, "");
-      this->export_code_table();
-      this->compress_data();
+      this->build_code_table();
     }
   }
 
   shared_ptr<HuffmanNode> & HuffmanTree::get_root() {
+    if(root == nullptr && !arena.empty()) {
+      root = arena.to_nodes(arena.get_root());
+    }
     return root;
   }
 
   void HuffmanTree::build_tree() {
-    // push nodes into the priority queue
-    for(auto x: frequencies) {
-        HuffmanNode n(x.first, x.second);
-        nodes.push(n);
-    }
-
-    // build tree
-    while(nodes.size() != 1) {
-      // create pointers for the lowest frequency letters 
-      shared_ptr<HuffmanNode> left = make_shared<HuffmanNode>(nodes.top());
-      nodes.pop();
-      shared_ptr<HuffmanNode> right = make_shared<HuffmanNode>(nodes.top());
-      nodes.pop();
-
-      // create parent node and set attributes of parent and siblings, then push parent
-      HuffmanNode p("", left->get_frequency() + right->get_frequency());
-      shared_ptr<HuffmanNode> parent = make_shared<HuffmanNode>(p);
-      parent->set_left(left);
-      parent->set_right(right);
-      nodes.push(*parent);
-    }
-
-    // last node is the root, so pop it out
-    root = std::make_shared<HuffmanNode>(nodes.top());
-    nodes.pop();
+    // the arena keeps all nodes in one block, so no per-node allocation
+    arena.build(histogram.data());
+    root = nullptr;
   }
 
   void HuffmanTree::load_data() {
-    ifstream data(input_file + ".txt");
+    this->load_data(false);
+  }
+
+  void HuffmanTree::load_data(bool release) {
+    // a fresh mapping, as a copy of the tree may share the last one; read-ahead
+    // waits until a sample is taken, so that only the sampled pages are read
+    input = make_shared<MappedFile>();
+    loaded = input->open(input_file + ".txt", sample_fraction <= 0) && input->size() != 0;
 
-    // if file not found
-    if(!data) {
-      loaded = false;
+    // if file not found or empty
+    if(!loaded) {
+      input->close();
       return;
     }
 
-    // if file is empty
-    if(data.peek() == ifstream::traits_type::eof()) {
-      loaded = false;
+    // update frequency table from a sample, or split across the pool if there is one
+    histogram.fill(0);
+    sampled = false;
+    if(sample_fraction > 0) {
+      sampled = sample_bytes(input->data(), input->size(), histogram.data(), sample_fraction) < input->size();
+      if(sampled) {
+        floor_counts(histogram.data());
+      }
+      input->advise(true);
+      if(release) {
+        input->release(0, input->size());
+      }
       return;
     }
 
-    loaded = true;
-    string line;
-
-    // read file
-    while(!data.eof()) {
-      getline(data, line);
-      original_data.push_back(line);
-
-      // update frequency table
-      for(int i = 0; i < line.length(); i++) {
-        string let(1, line[i]);
-        ++frequencies[let];
+    unique_ptr<ThreadPool> pool(threads == 1 ? nullptr : new ThreadPool(threads));
+    size_t step = release ? READ_BLOCK_SIZE : input->size();
+    for(size_t offset = 0; offset < input->size(); offset += step) {
+      size_t length = min(step, input->size() - offset);
+      if(pool) {
+        count_bytes(input->data() + offset, length, histogram.data(), *pool);
+      } else {
+        count_bytes(input->data() + offset, length, histogram.data());
+      }
+      if(release) {
+        input->release(offset, length);
       }
     }
   }
 
+  void HuffmanTree::build_code_table() {
+    // the leaves' depths are the code lengths
+    unsigned char lengths[256] = {0};
+    arena.code_lengths(lengths);
+    this->finish_code_table(lengths);
+  }
+
   void HuffmanTree::build_code_table(shared_ptr<HuffmanNode> root, string code) {
-    // traverse left subtree if child found, and add 0 to code
-    if(root->has_left()) {
-      this->build_code_table(root->get_left(), code + "0");
+    unsigned char lengths[256] = {0};
+    this->measure_depths(root, code.size(), lengths);
+    this->finish_code_table(lengths);
+  }
+
+  void HuffmanTree::finish_code_table(unsigned char* lengths) {
+    // if the tree is too deep, fall back to length-limited code lengths
+    codes.build(lengths, histogram.data(), max_code_length);
+
+    // reshape the tree so that walking it gives the canonical codes
+    arena.build_canonical(codes, histogram.data());
+    this->root = nullptr;
+  }
+
+  void HuffmanTree::measure_depths(shared_ptr<HuffmanNode> node, unsigned depth, unsigned char* lengths) {
+    if(node->has_left()) {
+      this->measure_depths(node->get_left(), depth + 1, lengths);
     }
 
-    // traverse right subtree if child found, and add 1 to code
-    if(root->has_right()) {
-      this->build_code_table(root->get_right(), code + "1");
+    if(node->has_right()) {
+      this->measure_depths(node->get_right(), depth + 1, lengths);
     }
 
-    // if no left or right child, insert current node's letter
-    // and code to the code table
-    code_table.insert(pair<string, string>(root->get_letter(), code));
+    if(!node->has_left() && !node->has_right()) {
+      // a tree of a single letter still needs one bit per letter
+      lengths[(unsigned char)node->get_letter()[0]] = depth == 0 ? 1 : depth;
+    }
   }
 
-  void HuffmanTree::export_code_table() {
-    // write code table to output file
-    ofstream codeStream(output_file + ".hdr");
-    codeStream << code_table.size() << endl;
+  void HuffmanTree::write_header(ostream & out, uint64_t bit_count) {
+    // only the code lengths are needed to rebuild canonical codes
+    vector<unsigned char> table;
+    codes.serialize(table);
 
-    for(auto x: code_table) {
-        codeStream << x.first << ":" << x.second << endl;
-    }
-    codeStream.close();
+    FileHeader header = { input->size(), bit_count, table.size() };
+    vector<unsigned char> fields;
+    write_file_header(fields, header);
+    out.write((const char*)fields.data(), fields.size());
+    out.write((const char*)table.data(), table.size());
   }
 
   void HuffmanTree::compress_data() {
+    // writing over the input would pull the mapped bytes out from under us
+    if(output_file == input_file) {
+      input->detach();
+    }
     ofstream compressed(output_file + ".txt");
     string buffer;
-    string line;
-
-    for(string line : original_data) {
-      // write letter codes to a string buffer
-      for(int i = 0; i < line.size(); i++) {
-        char a = line[i];
-        string let(1, line[i]);
-        buffer += code_table[let];
+
+    // write letter codes to a string buffer
+    for(size_t i = 0; i < input->size(); i++) {
+      const HuffmanCode & code = codes.get(input->data()[i]);
+      for(int b = code.length - 1; b >= 0; b--) {
+        buffer += (code.bits >> b) & 1 ? '1' : '0';
       }
     }
     compressed << buffer.c_str();
@@ -210,83 +265,136 @@ namespace YNGMAT005 {
   }
 
   void HuffmanTree::write_bits() {
-    ofstream bit_file(output_file + ".bin", ios::binary);
-    int size = 0;
+    ofstream bit_file(output_file + ".huf", ios::binary);
 
     // find and write number of bits in the file data
-    for(auto& line : original_data) {
-      for(auto& x : line) {
-        string ch(1, x);
-        size += code_table[ch].size();
-      }
-    }
-    bit_file << size << endl;
+    uint64_t size = this->count_bits();
+    this->write_header(bit_file, size);
 
     // byte buffer - minimum bytes needed to compress the file
-    int c_size = (size%8 ? floor(int(size/8)) + 1 : size/8);
-    unsigned char* bytes = new unsigned char[c_size];
+    size_t c_size = size / 8 + (size % 8 != 0);
+    unsigned char* bytes = new unsigned char[c_size]();
 
     // pack the bits into the byte buffer and write out to 
     // the binary file
-    this->pack(bytes, c_size, original_data);
-    for(int x = 0; x < c_size; x++) {
-      bit_file << bytes[x];
-    }
+    this->pack(bytes, c_size, input->data(), input->size());
+    bit_file.write((const char*)bytes, c_size);
     bit_file.close();
     delete [] bytes;  
   }
 
-  void HuffmanTree::pack(unsigned char* bytes, int BUFFER_SIZE, vector<string> & data) {
-    // set all byte values to 0 - not doing this caused strange behaviour
-    // when writing
-    for(int index = 0; index < BUFFER_SIZE; index++) {
-      bytes[index] = 0;
-    }
-
-    int c_index = 0;        // byte index
-    int bit_pointer = 7;    // bit position in current byte
-    int num_bits = 0;       // bit counter
-
-    for(auto& line : data) {
-      // for all bytes in each line
-      for(int c = 0; c < line.size(); c++) {
-        string letter(1, line[c]);
-        string code = code_table[letter];
-        int code_size = code.size();
-        int bit_index = 0;
-
-        // while there are bits to write
-        while(bit_index < code_size) {
-          num_bits++;
-          string nib(1, code[bit_index]);
-          int nib_val = stoi(nib);
-          // write bit to current working byte at bit position 'bit_pointer'
-          bytes[c_index] |= (nib_val << bit_pointer);
-          bit_pointer--;
-          bit_index++;
-
-          // if not done writing all bits of current code,
-          // prevent overflow and start writing in the next
-          // byte
-          if(bit_pointer < 0) {
-            c_index++;
-            bit_pointer = 7;
-          }
-        }
+  bool HuffmanTree::stream_bits() {
+    // count the letters over the mapped file, dropping each chunk's pages as it goes
+    this->load_data(true);
+    if(!loaded) {
+      return false;
+    }
+
+    this->build_tree();
+    this->build_code_table();
+
+    // find and write number of bits in the file data
+    uint64_t size = 0;
+    unsigned longest = 0;
+    for(int i = 0; i < 256; i++) {
+      size += histogram[i] * codes.get(i).length;
+      longest = max(longest, unsigned(codes.get(i).length));
+    }
+    // a sampled histogram only estimates the size, so the header is
+    // written again with the real one once the bits are encoded
+    ofstream bit_file(output_file + ".huf", ios::binary);
+    this->write_header(bit_file, size);
+
+    // encode each chunk into a buffer big enough for its longest possible
+    // output, and write the whole bytes out before moving on
+    vector<unsigned char> packed(READ_BLOCK_SIZE * longest / 8 + 16);
+    BitWriter writer(packed.data(), packed.size());
+
+    for(size_t offset = 0; offset < input->size(); offset += READ_BLOCK_SIZE) {
+      const unsigned char* chunk = input->data() + offset;
+      size_t length = min(READ_BLOCK_SIZE, input->size() - offset);
+      for(size_t i = 0; i < length; i++) {
+        const HuffmanCode & code = codes.get(chunk[i]);
+        writer.write(code.bits, code.length);
       }
+      bit_file.write((const char*)packed.data(), writer.bytes());
+      writer.restart();
+      input->release(offset, length);
     }
 
     // pad the last byte with 0s if it contains less than 8 bits
-    int padding = BUFFER_SIZE*8-num_bits;
-    for(int pads = 0; pads < padding; pads++) {
-      bytes[BUFFER_SIZE] |= (0 << (bit_pointer-pads));
-      bit_pointer--;
+    writer.flush();
+    bit_file.write((const char*)packed.data(), writer.bytes());
+    if(sampled) {
+      size = writer.written();
+      bit_file.seekp(0);
+      this->write_header(bit_file, size);
+    }
+    bit_file.close();
+    return writer.written() == size && bit_file.good();
+  }
+
+  bool HuffmanTree::write_blocks(size_t block_size) {
+    input = make_shared<MappedFile>();
+    loaded = input->open(input_file + ".txt", true);
+    if(!loaded) {
+      return false;
+    }
+
+    // blocks are encoded in place from the mapping
+    ofstream block_file(output_file + ".blk", ios::binary);
+    BlockCompressor compressor(block_size, threads);
+    compressor.set_max_code_length(max_code_length);
+    return compressor.compress(input->data(), input->size(), block_file);
+  }
+
+  bool HuffmanTree::read_blocks(ostream & out) {
+    MappedFile block_file;
+    if(!block_file.open(output_file + ".blk", true)) {
+      return false;
     }
+
+    // decode the blocks in parallel straight into one output buffer
+    vector<unsigned char> decoded;
+    BlockDecompressor decompressor(threads);
+    if(!decompressor.decompress(block_file.data(), block_file.size(), decoded)) {
+      return false;
+    }
+    out.write((const char*)decoded.data(), decoded.size());
+    return out.good();
+  }
+
+  bool HuffmanTree::read_range(uint64_t offset, uint64_t length, string & out) {
+    // only the pages of the table, the checkpoints and the blocks in range are touched
+    MappedFile block_file;
+    if(!block_file.open(output_file + ".blk", false)) {
+      return false;
+    }
+
+    vector<unsigned char> decoded;
+    if(!BlockDecompressor::decode_range(block_file.data(), block_file.size(), offset, length, decoded)) {
+      return false;
+    }
+    out.assign(decoded.begin(), decoded.end());
+    return true;
+  }
+
+  void HuffmanTree::pack(unsigned char* bytes, size_t BUFFER_SIZE, const unsigned char* data, size_t size) {
+    BitWriter writer(bytes, BUFFER_SIZE);
+
+    // append each letter's whole code to the bit writer
+    for(size_t i = 0; i < size; i++) {
+      const HuffmanCode & code = codes.get(data[i]);
+      writer.write(code.bits, code.length);
+    }
+
+    // pad the last byte with 0s if it contains less than 8 bits
+    writer.flush();
   }
 
-  string HuffmanTree::unpack(unsigned char* bytes, int BUFFER_SIZE, int shift_offset) {
+  string HuffmanTree::unpack(unsigned char* bytes, size_t BUFFER_SIZE, int shift_offset) {
     string unpacked = "";
-    for(int i = 0; i < BUFFER_SIZE; i++) {
+    for(size_t i = 0; i < BUFFER_SIZE; i++) {
       unsigned char byte = bytes[i];
       // extract bits from byte and add to buffer
       for(int bit = 0; bit < 8; bit++) {
@@ -298,47 +406,87 @@ namespace YNGMAT005 {
   }
 
   string HuffmanTree::read_bits() {
-    ifstream bit_file(output_file + ".bin", ios::binary);
-
-    // get number of bits in the file
-    string size;
-    getline(bit_file, size);
-    int s = stoi(size);
+    string decoded;
+    MappedFile bit_file;
+    HuffmanDecoder decoder;
+    FileHeader header;
+    size_t offset = 0;
+
+    if(this->open_bit_stream(bit_file, decoder, header, offset)) {
+      BitReader reader(bit_file.data() + offset, bit_file.size() - offset);
+      decoded.reserve(header.raw_size);
+      // most bit patterns decode to something, so a corrupt file shows up as the wrong number of letters
+      if(!decoder.decode(reader, header.bit_count, decoded) || decoded.size() != header.raw_size) {
+        decoded.clear();
+      }
+    }
+    return decoded;
+  }
 
-    // get number of bytes from number of bits
-    int num_bytes = ceil(int(s/8)) + 1;
-    int shift_offset = num_bytes*8 - s;
+  bool HuffmanTree::read_bits(ostream & out) {
+    MappedFile bit_file;
+    HuffmanDecoder decoder;
+    FileHeader header;
+    size_t offset = 0;
 
-    // start reading unsigned chars from second line
-    bit_file.seekg(size.size() + 1, ios::beg);
+    if(!this->open_bit_stream(bit_file, decoder, header, offset)) {
+      return false;
+    }
 
-    // read and unpack data
-    unsigned char* bytes = new unsigned char[num_bytes];
-    bit_file.read((char*)bytes, num_bytes);
-    bit_file.close();
-    string unpacked = this->unpack(bytes, num_bytes, shift_offset);
-    cout << "Unpacked bits: " << unpacked << endl;
+    // decode straight from the mapping a buffer at a time into the output,
+    // handing back the pages of the bits behind the reader as it goes
+    BitReader reader(bit_file.data() + offset, bit_file.size() - offset);
+    vector<unsigned char> decoded(READ_BLOCK_SIZE);
+    size_t released = 0;
+    uint64_t total = 0;
+    while(reader.consumed() < header.bit_count) {
+      size_t written = 0;
+      if(!decoder.decode(reader, header.bit_count, decoded.data(), decoded.size(), written)) {
+        return false;
+      }
+      out.write((const char*)decoded.data(), written);
+      total += written;
+      size_t read = offset + reader.consumed() / 8;
+      bit_file.release(released, read - released);
+      released = read;
+    }
+    return reader.consumed() == header.bit_count && total == header.raw_size && out.good();
+  }
 
-    // decode unpacked data
-    string decoded;
-    string dec_buffer;
-
-    // do a longest prefix search to decode message
-    for(int i = 0; i < unpacked.size(); i++) {
-      string bit(1, unpacked[i]);
-      dec_buffer = dec_buffer + bit;
-      // search tree
-      string letter = this->search_tree(this->get_root(), dec_buffer);
-
-      if(letter != "") {
-        decoded += letter;
-        dec_buffer = "";
+  uint64_t HuffmanTree::count_bits() {
+    uint64_t bits = 0;
+    if(!sampled) {
+      for(int i = 0; i < 256; i++) {
+        bits += histogram[i] * codes.get(i).length;
       }
+      return bits;
     }
 
-    // clean up memory
-    delete [] bytes;
-    return decoded;
+    // sampled counts aren't the real ones, so go over the input itself
+    for(size_t i = 0; i < input->size(); i++) {
+      bits += codes.get(input->data()[i]).length;
+    }
+    return bits;
+  }
+
+  bool HuffmanTree::open_bit_stream(MappedFile & bit_file, HuffmanDecoder & decoder, FileHeader & header, size_t & offset) {
+    if(!bit_file.open(output_file + ".huf", true)) {
+      return false;
+    }
+
+    // the fixed header alone says whether the sections fit the file
+    if(!read_file_header(bit_file.data(), bit_file.size(), header)) {
+      return false;
+    }
+
+    // rebuild the canonical codes from the code lengths following the header
+    size_t used = 0;
+    if(!codes.deserialize(bit_file.data() + FILE_HEADER_SIZE, header.table_size, used) ||
+      used != header.table_size || !decoder.build(codes)) {
+      return false;
+    }
+    offset = FILE_HEADER_SIZE + header.table_size;
+    return true;
   }
 
   string HuffmanTree::search_tree(shared_ptr<HuffmanNode> root, string code) {
@@ -394,7 +542,7 @@ namespace YNGMAT005 {
 
   void HuffmanTree::print_codes() {
     if(loaded) {
-      for(auto x: code_table) {
+      for(auto x: this->get_code_table()) {
         cout << x.first << ":" << x.second << endl;
       } 
     }
@@ -408,15 +556,39 @@ namespace YNGMAT005 {
     this->input_file = input_file;
   }
 
+  void HuffmanTree::set_max_code_length(unsigned length) {
+    max_code_length = length;
+  }
+
+  void HuffmanTree::set_threads(unsigned threads) {
+    this->threads = threads;
+  }
+
+  void HuffmanTree::set_sample_fraction(double fraction) {
+    sample_fraction = fraction;
+  }
+
   bool HuffmanTree::has_loaded() {
     return loaded;
   }
 
-  unordered_map<string, int> HuffmanTree::get_frequency_table() {
+  unordered_map<string, uint64_t> HuffmanTree::get_frequency_table() {
+    unordered_map<string, uint64_t> frequencies;
+    for(int i = 0; i < 256; i++) {
+      if(histogram[i] != 0) {
+        frequencies[string(1, i)] = histogram[i];
+      }
+    }
     return frequencies;
   }
 
   unordered_map<string, string> HuffmanTree::get_code_table() {
+    unordered_map<string, string> code_table;
+    for(int i = 0; i < 256; i++) {
+      if(codes.contains(i)) {
+        code_table[string(1, i)] = codes.bit_string(i);
+      }
+    }
     return code_table;
   }
 
@@ -0,0 +1,150 @@
+// Test class to test adaptive streaming compression
+
+#include "huffmanadaptive.h"
+#include "huffmanbits.h"
+#include <cstdint>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "catch.hpp"
+
+using namespace std;
+using namespace YNGMAT005;
+
+SCENARIO("The model starts flat and follows the data", "[AdaptiveModel]") {
+	GIVEN("A fresh model") {
+		AdaptiveModel model(1000);
+
+		THEN("Every byte has an 8 bit code") {
+			for(int i = 0; i < 256; i++) {
+				REQUIRE(model.get_codes().get(i).length == 8);
+			}
+		}
+
+		WHEN("A skewed chunk goes past the rebuild interval") {
+			string chunk(2000, 'e');
+			REQUIRE(model.update((const unsigned char*)chunk.data(), 500) == false);
+			REQUIRE(model.update((const unsigned char*)chunk.data(), chunk.size()) == true);
+
+			THEN("Its common byte gets a short code and the rest keep theirs") {
+				REQUIRE(model.get_codes().get('e').length == 1);
+				REQUIRE(model.get_codes().get('z').length > 8);
+			}
+		}
+	}
+}
+
+SCENARIO("Streams are compressed in one pass", "[AdaptiveEncoder]") {
+	GIVEN("A stream whose letters change partway through") {
+		string data;
+		for(int i = 0; i < 300000; i++) {
+			data += char(i < 150000 ? 'a' + rand() % 4 : 'p' + rand() % 8);
+		}
+
+		WHEN("It is compressed from one stream to another") {
+			AdaptiveEncoder encoder(1 << 14);
+			istringstream in(data);
+			ostringstream out;
+			REQUIRE(encoder.compress(in, out) == true);
+
+			THEN("It shrinks and decodes back with a mirrored model") {
+				REQUIRE(out.str().size() < data.size() / 2);
+				AdaptiveDecoder decoder;
+				istringstream packed(out.str());
+				ostringstream restored;
+				REQUIRE(decoder.decompress(packed, restored) == true);
+				REQUIRE(restored.str() == data);
+			}
+
+			THEN("The decoder takes its rebuild interval from the stream") {
+				vector<unsigned char> interval;
+				put_varint(interval, 1 << 14);
+				REQUIRE(out.str().compare(0, interval.size(), string(interval.begin(), interval.end())) == 0);
+			}
+
+			THEN("A stream with its interval changed is rejected or decodes exactly") {
+				vector<unsigned char> interval;
+				put_varint(interval, 1 << 15);
+				string stream = out.str();
+				stream.replace(0, interval.size(), string(interval.begin(), interval.end()));
+				AdaptiveDecoder decoder;
+				istringstream packed(stream);
+				ostringstream restored;
+				bool ok = decoder.decompress(packed, restored);
+				REQUIRE((ok == false || restored.str() == data));
+			}
+
+			THEN("A stream with a zero interval is rejected") {
+				string stream = out.str();
+				stream.replace(0, 3, string(1, '\0'));
+				AdaptiveDecoder decoder;
+				istringstream packed(stream);
+				ostringstream restored;
+				REQUIRE(decoder.decompress(packed, restored) == false);
+			}
+
+			THEN("A stream missing its end marker is rejected") {
+				AdaptiveDecoder decoder;
+				istringstream packed(out.str().substr(0, out.str().size() - 1));
+				ostringstream restored;
+				REQUIRE(decoder.decompress(packed, restored) == false);
+			}
+
+			THEN("A frame claiming far more bits than the stream holds is rejected") {
+				// 2^40 letters in 2^37 bytes agree with each other, but nothing follows them
+				vector<unsigned char> frame;
+				put_varint(frame, 1 << 14);
+				put_varint(frame, uint64_t(1) << 40);
+				put_varint(frame, uint64_t(1) << 37);
+				AdaptiveDecoder decoder;
+				istringstream packed(string(frame.begin(), frame.end()));
+				ostringstream restored;
+				REQUIRE(decoder.decompress(packed, restored) == false);
+			}
+		}
+
+		WHEN("It arrives in small pieces") {
+			AdaptiveEncoder encoder(4096);
+			AdaptiveDecoder decoder;
+			string restored;
+			bool all_decoded = true;
+
+			for(size_t offset = 0; offset < data.size(); offset += 777) {
+				size_t size = min(size_t(777), data.size() - offset);
+				vector<unsigned char> frame, decoded;
+				encoder.encode((const unsigned char*)data.data() + offset, size, frame);
+
+				size_t used = 0;
+				bool finished = true;
+				all_decoded = all_decoded && decoder.decode(frame.data(), frame.size(), used, decoded, finished);
+				all_decoded = all_decoded && used == frame.size() && !finished;
+				restored.append(decoded.begin(), decoded.end());
+			}
+
+			THEN("Each piece decodes as soon as its frame arrives") {
+				REQUIRE(all_decoded == true);
+				REQUIRE(restored == data);
+			}
+		}
+
+		WHEN("The stream is empty") {
+			AdaptiveEncoder encoder(0);
+			istringstream in("");
+			ostringstream out;
+			encoder.compress(in, out);
+
+			THEN("Only the rebuild interval and the end marker are written") {
+				vector<unsigned char> expected;
+				put_varint(expected, ADAPTIVE_REBUILD_INTERVAL);
+				put_varint(expected, 0);
+				REQUIRE(out.str() == string(expected.begin(), expected.end()));
+				AdaptiveDecoder decoder;
+				istringstream packed(out.str());
+				ostringstream restored;
+				REQUIRE(decoder.decompress(packed, restored) == true);
+				REQUIRE(restored.str() == "");
+			}
+		}
+	}
+}
@@ -0,0 +1,132 @@
+// Test class to test the index-based Huffman tree arena
+
+#include "huffmanarena.h"
+#include "huffmancodetable.h"
+#include "huffmannode.h"
+#include <cstdint>
+#include <memory>
+#include "catch.hpp"
+
+using namespace std;
+using namespace YNGMAT005;
+
+SCENARIO("A tree is built in the arena from byte frequencies", "[HuffmanArena]") {
+	GIVEN("Frequencies a:4 b:3 c:2 d:1") {
+		uint64_t frequencies[256] = {0};
+		frequencies['a'] = 4;
+		frequencies['b'] = 3;
+		frequencies['c'] = 2;
+		frequencies['d'] = 1;
+		HuffmanArena arena;
+
+		WHEN("The tree is built") {
+			arena.build(frequencies);
+
+			THEN("There is a leaf per letter and a parent per join") {
+				REQUIRE(arena.size() == 7);
+				REQUIRE(arena.get(arena.get_root()).frequency == 10);
+			}
+
+			THEN("The leaves' depths are the Huffman code lengths") {
+				unsigned char lengths[256] = {0};
+				arena.code_lengths(lengths);
+				REQUIRE(lengths['a'] == 1);
+				REQUIRE(lengths['b'] == 2);
+				REQUIRE(lengths['c'] == 3);
+				REQUIRE(lengths['d'] == 3);
+				REQUIRE(lengths['e'] == 0);
+			}
+
+			THEN("The linked copy has the same shape and frequencies") {
+				shared_ptr<HuffmanNode> root = arena.to_nodes(arena.get_root());
+				REQUIRE(root->get_frequency() == 10);
+				uint64_t children = root->get_left()->get_frequency() + root->get_right()->get_frequency();
+				REQUIRE(children == 10);
+				REQUIRE(root->get_letter() == "");
+			}
+		}
+
+		WHEN("The counts don't fit in 32 bits") {
+			frequencies['a'] = uint64_t(5) << 32;
+			frequencies['b'] = uint64_t(3) << 32;
+			arena.build(frequencies);
+
+			THEN("The linked copy keeps them whole") {
+				shared_ptr<HuffmanNode> root = arena.to_nodes(arena.get_root());
+				uint64_t total = (uint64_t(8) << 32) + 3;
+				REQUIRE(root->get_frequency() == total);
+			}
+		}
+
+		WHEN("The tree is rebuilt from canonical codes") {
+			unsigned char lengths[256] = {0};
+			lengths['a'] = 1;
+			lengths['b'] = 2;
+			lengths['c'] = 3;
+			lengths['d'] = 3;
+			HuffmanCodeTable codes;
+			codes.assign_canonical(lengths);
+			arena.build_canonical(codes, frequencies);
+
+			THEN("Following a code from the root leads to its letter") {
+				// b is 10: right, then left
+				uint32_t node = arena.get(arena.get_root()).right;
+				node = arena.get(node).left;
+				REQUIRE(arena.is_leaf(node) == true);
+				REQUIRE(arena.get(node).letter == 'b');
+				REQUIRE(arena.get(node).frequency == 3);
+			}
+		}
+	}
+
+	GIVEN("Frequencies with many ties") {
+		uint64_t frequencies[256] = {0};
+		frequencies['v'] = 1;
+		frequencies['b'] = frequencies['i'] = frequencies['n'] = frequencies['r'] = 2;
+		frequencies['d'] = frequencies['l'] = frequencies['s'] = 3;
+		HuffmanArena arena;
+		arena.build(frequencies);
+
+		THEN("Ties prefer leaves, giving the shallowest optimal tree") {
+			unsigned char lengths[256] = {0};
+			arena.code_lengths(lengths);
+			uint64_t cost = 0;
+			for(int i = 0; i < 256; i++) {
+				REQUIRE(lengths[i] <= 3);
+				cost += frequencies[i] * lengths[i];
+			}
+			REQUIRE(cost == 54);
+		}
+
+		THEN("Parents are made in order of frequency") {
+			for(uint32_t i = 9; i < arena.size(); i++) {
+				REQUIRE(arena.get(i - 1).frequency <= arena.get(i).frequency);
+			}
+		}
+	}
+
+	GIVEN("A single letter") {
+		uint64_t frequencies[256] = {0};
+		frequencies['z'] = 9;
+		HuffmanArena arena;
+		arena.build(frequencies);
+
+		THEN("The root is a leaf that still gets a one bit code") {
+			unsigned char lengths[256] = {0};
+			arena.code_lengths(lengths);
+			REQUIRE(arena.is_leaf(arena.get_root()) == true);
+			REQUIRE(lengths['z'] == 1);
+		}
+	}
+
+	GIVEN("No letters") {
+		uint64_t frequencies[256] = {0};
+		HuffmanArena arena;
+		arena.build(frequencies);
+
+		THEN("The arena is empty") {
+			REQUIRE(arena.empty() == true);
+			REQUIRE(arena.get_root() == NO_NODE);
+		}
+	}
+}
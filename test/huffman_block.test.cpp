@@ -0,0 +1,313 @@
+// Test class to test the block container
+
+#include "huffmanblock.h"
+#include "huffmanbits.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "catch.hpp"
+
+using namespace std;
+using namespace YNGMAT005;
+
+SCENARIO("Blocks are encoded independently", "[BlockCompressor]") {
+	GIVEN("Two halves with different letters") {
+		string data = string(1000, 'a') + "bab" + string(1000, 'z') + "yzy";
+		BlockCompressor compressor(1003, 1);
+
+		WHEN("One block is encoded") {
+			vector<unsigned char> frame;
+			compressor.encode_block((const unsigned char*)data.data(), 1003, frame);
+
+			THEN("Its header describes only its own letters") {
+				BlockHeader header;
+				REQUIRE(BlockDecompressor::read_header(frame.data(), frame.size(), header) == true);
+				REQUIRE(header.raw_size == 1003);
+				REQUIRE(header.codes.size() == 2);
+				REQUIRE(header.codes.contains('z') == false);
+				size_t block_size = header.header_size + header.payload_size;
+				REQUIRE(block_size == frame.size());
+			}
+
+			THEN("It decodes back on its own") {
+				BlockHeader header;
+				BlockDecompressor::read_header(frame.data(), frame.size(), header);
+				vector<unsigned char> out(header.raw_size);
+				REQUIRE(BlockDecompressor::decode_block(header, frame.data() + header.header_size, out.data()) == true);
+				REQUIRE(string(out.begin(), out.end()) == data.substr(0, 1003));
+			}
+
+			THEN("A header whose sizes can't agree is rejected") {
+				BlockHeader header;
+				vector<unsigned char> damaged = frame;
+				damaged[7] ^= 0x10;
+				REQUIRE(BlockDecompressor::read_header(damaged.data(), damaged.size(), header) == false);
+				damaged = frame;
+				damaged[15] ^= 0x10;
+				REQUIRE(BlockDecompressor::read_header(damaged.data(), damaged.size(), header) == false);
+			}
+		}
+	}
+}
+
+SCENARIO("Containers round trip through several threads", "[BlockCompressor]") {
+	GIVEN("Input spanning many blocks") {
+		string data;
+		for(int i = 0; i < 100000; i++) {
+			data += char(i < 50000 ? 'a' + rand() % 4 : rand() % 256);
+		}
+
+		WHEN("It is compressed with four threads") {
+			BlockCompressor compressor(4096, 4);
+			istringstream in(data);
+			ostringstream out;
+			REQUIRE(compressor.compress(in, out) == true);
+
+			THEN("Decompressing gives the input back in order") {
+				BlockDecompressor decompressor;
+				istringstream packed(out.str());
+				ostringstream restored;
+				REQUIRE(decompressor.decompress(packed, restored) == true);
+				REQUIRE(restored.str() == data);
+			}
+
+			THEN("Compressing the input in place gives the same container") {
+				ostringstream in_place;
+				REQUIRE(compressor.compress((const unsigned char*)data.data(), data.size(), in_place) == true);
+				REQUIRE(in_place.str() == out.str());
+			}
+
+			THEN("A truncated container is rejected") {
+				BlockDecompressor decompressor;
+				istringstream packed(out.str().substr(0, out.str().size() / 2));
+				ostringstream restored;
+				REQUIRE(decompressor.decompress(packed, restored) == false);
+			}
+
+			THEN("A block claiming far more data than the stream holds is rejected") {
+				// raw size 2^40 and bit count 2^41 agree with each other, but not with the stream
+				string damaged = out.str();
+				vector<unsigned char> sizes;
+				put_le(sizes, uint64_t(1) << 40, 8);
+				put_le(sizes, uint64_t(1) << 41, 8);
+				damaged.replace(5, 16, string(sizes.begin(), sizes.end()));
+				BlockDecompressor decompressor;
+				istringstream packed(damaged);
+				ostringstream restored;
+				REQUIRE(decompressor.decompress(packed, restored) == false);
+			}
+		}
+
+		WHEN("The input is empty") {
+			BlockCompressor compressor(4096, 2);
+			istringstream in("");
+			ostringstream out;
+			compressor.compress(in, out);
+
+			THEN("The container holds no blocks") {
+				BlockDecompressor decompressor;
+				istringstream packed(out.str());
+				ostringstream restored;
+				REQUIRE(decompressor.decompress(packed, restored) == true);
+				REQUIRE(restored.str() == "");
+			}
+		}
+	}
+}
+
+SCENARIO("Blocks are decoded in parallel through the block table", "[BlockDecompressor]") {
+	GIVEN("A container of many blocks") {
+		string data;
+		for(int i = 0; i < 100000; i++) {
+			data += char(i % 3 == 0 ? rand() % 256 : 'a' + rand() % 8);
+		}
+		BlockCompressor compressor(3000, 2);
+		istringstream in(data);
+		ostringstream out;
+		compressor.compress(in, out);
+		string container = out.str();
+		const unsigned char* bytes = (const unsigned char*)container.data();
+
+		WHEN("The block table is read") {
+			vector<BlockEntry> table;
+			REQUIRE(BlockDecompressor::read_table(bytes, container.size(), table) == true);
+
+			THEN("It lists every block with its place in the output") {
+				REQUIRE(table.size() == 34);
+				REQUIRE(table.front().offset == 5);
+				REQUIRE(table.front().raw_offset == 0);
+				REQUIRE(table[1].raw_offset == 3000);
+				REQUIRE(table.back().raw_size == 1000);
+
+				BlockHeader header;
+				REQUIRE(BlockDecompressor::read_header(bytes + table[1].offset, container.size() - table[1].offset, header) == true);
+				REQUIRE(header.raw_size == 3000);
+			}
+		}
+
+		WHEN("It is decoded on four threads") {
+			BlockDecompressor decompressor(4);
+			vector<unsigned char> restored;
+			REQUIRE(decompressor.decompress(bytes, container.size(), restored) == true);
+
+			THEN("Every block lands in its own slot") {
+				REQUIRE(string(restored.begin(), restored.end()) == data);
+			}
+		}
+
+		WHEN("A block is corrupted") {
+			vector<BlockEntry> table;
+			BlockDecompressor::read_table(bytes, container.size(), table);
+			string damaged = container;
+			damaged[table[5].offset] ^= 1;
+			BlockDecompressor decompressor(4);
+			vector<unsigned char> restored;
+
+			THEN("Decoding fails") {
+				REQUIRE(decompressor.decompress((const unsigned char*)damaged.data(), damaged.size(), restored) == false);
+			}
+		}
+
+		WHEN("The table's raw sizes are tampered with") {
+			uint64_t table_offset = get_le(bytes + container.size() - FOOTER_SIZE + 8, 8);
+			BlockDecompressor decompressor(4);
+			vector<unsigned char> restored;
+
+			THEN("Sizes that wrap the running total are rejected") {
+				string damaged = container;
+				vector<unsigned char> sizes;
+				put_le(sizes, uint64_t(0) - 2000, 8);
+				damaged.replace(table_offset + 8, 8, string(sizes.begin(), sizes.end()));
+				const unsigned char* damaged_bytes = (const unsigned char*)damaged.data();
+				vector<BlockEntry> table;
+				REQUIRE(BlockDecompressor::read_table(damaged_bytes, damaged.size(), table) == false);
+				REQUIRE(decompressor.decompress(damaged_bytes, damaged.size(), restored) == false);
+			}
+
+			THEN("A size far beyond the container is rejected before anything is allocated") {
+				string damaged = container;
+				vector<unsigned char> sizes;
+				put_le(sizes, uint64_t(1) << 45, 8);
+				damaged.replace(table_offset + TABLE_ENTRY_SIZE + 8, 8, string(sizes.begin(), sizes.end()));
+				REQUIRE(decompressor.decompress((const unsigned char*)damaged.data(), damaged.size(), restored) == false);
+			}
+		}
+
+		WHEN("The footer is missing") {
+			BlockDecompressor decompressor(4);
+			vector<unsigned char> restored;
+
+			THEN("The container is rejected") {
+				REQUIRE(decompressor.decompress(bytes, container.size() - 1, restored) == false);
+			}
+		}
+	}
+}
+
+SCENARIO("Blocks can be split into interleaved streams", "[BlockCompressor]") {
+	GIVEN("A block with codes of several lengths") {
+		string data;
+		for(int i = 0; i < 20003; i++) {
+			data += char(i % 5 == 0 ? rand() % 64 : 'a' + rand() % 3);
+		}
+		BlockCompressor compressor(data.size(), 1);
+
+		WHEN("It is encoded as four streams") {
+			REQUIRE(compressor.set_streams(DECODE_STREAMS) == true);
+			vector<unsigned char> frame;
+			compressor.encode_block((const unsigned char*)data.data(), data.size(), frame);
+			BlockHeader header;
+			REQUIRE(BlockDecompressor::read_header(frame.data(), frame.size(), header) == true);
+
+			THEN("The header accounts for every stream's bits") {
+				REQUIRE(header.streams == DECODE_STREAMS);
+				uint64_t bits = header.stream_bits[0] + header.stream_bits[1] + header.stream_bits[2] + header.stream_bits[3];
+				REQUIRE(bits == header.bit_count);
+				size_t block_size = header.header_size + header.payload_size;
+				REQUIRE(block_size == frame.size());
+			}
+
+			THEN("It decodes back in order") {
+				vector<unsigned char> out(header.raw_size);
+				REQUIRE(BlockDecompressor::decode_block(header, frame.data() + header.header_size, out.data()) == true);
+				REQUIRE(string(out.begin(), out.end()) == data);
+			}
+		}
+
+		WHEN("It is encoded as one stream") {
+			REQUIRE(compressor.set_streams(1) == true);
+			vector<unsigned char> frame;
+			compressor.encode_block((const unsigned char*)data.data(), data.size(), frame);
+			BlockHeader header;
+			BlockDecompressor::read_header(frame.data(), frame.size(), header);
+
+			THEN("It still decodes") {
+				REQUIRE(header.streams == 1);
+				vector<unsigned char> out(header.raw_size);
+				REQUIRE(BlockDecompressor::decode_block(header, frame.data() + header.header_size, out.data()) == true);
+				REQUIRE(string(out.begin(), out.end()) == data);
+			}
+		}
+
+		WHEN("Another stream count is asked for") {
+			THEN("It is refused") {
+				REQUIRE(compressor.set_streams(3) == false);
+			}
+		}
+	}
+}
+
+SCENARIO("Byte ranges are decoded from the nearest checkpoint", "[BlockDecompressor]") {
+	GIVEN("Blocks with checkpoints every 1000 bytes") {
+		string data;
+		for(int i = 0; i < 50000; i++) {
+			data += char(i % 7 == 0 ? rand() % 256 : 'a' + rand() % 5);
+		}
+
+		for(unsigned streams = 1; streams <= DECODE_STREAMS; streams += DECODE_STREAMS - 1) {
+			BlockCompressor compressor(12000, 2);
+			compressor.set_streams(streams);
+			compressor.set_checkpoint_interval(1000);
+			istringstream in(data);
+			ostringstream out;
+			compressor.compress(in, out);
+			string container = out.str();
+			const unsigned char* bytes = (const unsigned char*)container.data();
+
+			WHEN("Ranges are decoded with " + to_string(streams) + " streams per block") {
+				vector<unsigned char> range;
+
+				THEN("Each comes back exactly") {
+					uint64_t starts[] = { 0, 999, 1000, 11999, 12000, 25431, 49990 };
+					for(auto start : starts) {
+						uint64_t length = min(uint64_t(2500), uint64_t(data.size()) - start);
+						REQUIRE(BlockDecompressor::decode_range(bytes, container.size(), start, length, range) == true);
+						REQUIRE(string(range.begin(), range.end()) == data.substr(start, length));
+					}
+				}
+
+				THEN("A range past the end is rejected") {
+					REQUIRE(BlockDecompressor::decode_range(bytes, container.size(), 49990, 11, range) == false);
+				}
+			}
+		}
+
+		WHEN("The container has no checkpoints") {
+			BlockCompressor compressor(12000, 1);
+			compressor.set_checkpoint_interval(0);
+			istringstream in(data);
+			ostringstream out;
+			compressor.compress(in, out);
+			string container = out.str();
+			vector<unsigned char> range;
+
+			THEN("Ranges are decoded from the start of their blocks") {
+				REQUIRE(BlockDecompressor::decode_range((const unsigned char*)container.data(), container.size(), 30000, 100, range) == true);
+				REQUIRE(string(range.begin(), range.end()) == data.substr(30000, 100));
+			}
+		}
+	}
+}
@@ -0,0 +1,151 @@
+// Test class to test canonical code table construction and serialization
+
+#include "huffmancodetable.h"
+#include <cstdint>
+#include <vector>
+#include "catch.hpp"
+
+using namespace std;
+using namespace YNGMAT005;
+
+SCENARIO("Canonical codes are assigned from code lengths", "[HuffmanCodeTable]") {
+	GIVEN("Code lengths a:2 b:1 c:3 d:3") {
+		unsigned char lengths[256] = {0};
+		lengths['a'] = 2;
+		lengths['b'] = 1;
+		lengths['c'] = 3;
+		lengths['d'] = 3;
+		HuffmanCodeTable table;
+
+		WHEN("Canonical codes are assigned") {
+			REQUIRE(table.assign_canonical(lengths) == true);
+
+			THEN("Shorter codes come first and ties follow byte order") {
+				REQUIRE(table.get('b').bits == 0x0);
+				REQUIRE(table.get('a').bits == 0x2);
+				REQUIRE(table.get('c').bits == 0x6);
+				REQUIRE(table.get('d').bits == 0x7);
+				REQUIRE(table.get('a').length == 2);
+				REQUIRE(table.size() == 4);
+				REQUIRE(table.contains('e') == false);
+			}
+		}
+
+		WHEN("The lengths describe more codes than fit in a prefix code") {
+			lengths['e'] = 1;
+
+			THEN("No codes are assigned") {
+				REQUIRE(table.assign_canonical(lengths) == false);
+			}
+		}
+	}
+}
+
+SCENARIO("A code table survives serialization", "[HuffmanCodeTable]") {
+	GIVEN("A canonical table") {
+		unsigned char lengths[256] = {0};
+		lengths['x'] = 1;
+		lengths['y'] = 2;
+		lengths['z'] = 2;
+		HuffmanCodeTable table;
+		table.assign_canonical(lengths);
+
+		WHEN("It is serialized") {
+			vector<unsigned char> header;
+			table.serialize(header);
+
+			THEN("Only the code lengths are written") {
+				REQUIRE(header.size() == 7);
+			}
+
+			THEN("Deserializing gives back the same codes") {
+				HuffmanCodeTable copy;
+				size_t used = 0;
+				REQUIRE(copy.deserialize(header.data(), header.size(), used) == true);
+				REQUIRE(used == header.size());
+				for(int i = 0; i < 256; i++) {
+					REQUIRE(copy.get(i).bits == table.get(i).bits);
+					REQUIRE(copy.get(i).length == table.get(i).length);
+				}
+			}
+
+			THEN("A truncated header is rejected") {
+				HuffmanCodeTable copy;
+				size_t used = 0;
+				REQUIRE(copy.deserialize(header.data(), header.size() - 1, used) == false);
+			}
+		}
+	}
+}
+
+SCENARIO("Code lengths can be limited with package-merge", "[HuffmanCodeTable]") {
+	GIVEN("Doubling frequencies that give a Huffman tree 19 levels deep") {
+		uint64_t frequencies[256] = {0};
+		for(int i = 0; i < 20; i++) {
+			frequencies['a' + i] = uint64_t(1) << i;
+		}
+		HuffmanCodeTable table;
+
+		WHEN("The limit is above the tree's depth") {
+			REQUIRE(table.build_limited(frequencies, 30) == true);
+
+			THEN("The lengths are those of the Huffman tree") {
+				REQUIRE(table.get('t').length == 1);
+				REQUIRE(table.get('s').length == 2);
+				REQUIRE(table.get('b').length == 19);
+				REQUIRE(table.get('a').length == 19);
+			}
+		}
+
+		WHEN("The lengths are limited to 8 bits") {
+			REQUIRE(table.build_limited(frequencies, 8) == true);
+
+			THEN("No code is longer than the limit and the code is complete") {
+				uint64_t kraft = 0;
+				for(int i = 0; i < 20; i++) {
+					unsigned length = table.get('a' + i).length;
+					REQUIRE(length >= 1);
+					REQUIRE(length <= 8);
+					kraft += uint64_t(1) << (8 - length);
+				}
+				REQUIRE(kraft == 256);
+			}
+
+			THEN("More frequent letters never get longer codes") {
+				for(int i = 1; i < 20; i++) {
+					REQUIRE(table.get('a' + i).length <= table.get('a' + i - 1).length);
+				}
+			}
+		}
+
+		WHEN("The tree's own lengths are handed in with a limit") {
+			unsigned char lengths[256] = {0};
+			for(int i = 0; i < 20; i++) {
+				lengths['a' + i] = i < 2 ? 19 : 20 - i;
+			}
+
+			THEN("They are used as they are while they fit") {
+				REQUIRE(table.build(lengths, frequencies, 0) == true);
+				REQUIRE(table.get('a').length == 19);
+				REQUIRE(table.get('t').length == 1);
+			}
+
+			THEN("They are replaced by limited lengths when they don't") {
+				REQUIRE(table.build(lengths, frequencies, 8) == true);
+				for(int i = 0; i < 20; i++) {
+					REQUIRE(table.get('a' + i).length <= 8);
+				}
+			}
+		}
+
+		WHEN("The limit is too small for the number of letters") {
+			REQUIRE(table.build_limited(frequencies, 2) == true);
+
+			THEN("The shortest possible limit is used instead") {
+				for(int i = 0; i < 20; i++) {
+					REQUIRE(table.get('a' + i).length <= 5);
+				}
+			}
+		}
+	}
+}
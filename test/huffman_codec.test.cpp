@@ -0,0 +1,99 @@
+// Test class to test in-memory compression
+
+#include "huffmancodec.h"
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "catch.hpp"
+
+using namespace std;
+using namespace YNGMAT005;
+
+SCENARIO("Buffers are compressed in memory", "[HuffmanCodec]") {
+	GIVEN("A codec") {
+		HuffmanCodec codec;
+
+		WHEN("A short message is compressed") {
+			string message = "the quick brown fox jumps over the lazy dog";
+			vector<unsigned char> packed = codec.compress((const unsigned char*)message.data(), message.size());
+
+			THEN("It decompresses back to the message") {
+				vector<unsigned char> restored;
+				REQUIRE(codec.decompress(packed.data(), packed.size(), restored) == true);
+				REQUIRE(string(restored.begin(), restored.end()) == message);
+			}
+
+			THEN("Truncated or padded buffers are rejected") {
+				vector<unsigned char> restored;
+				REQUIRE(codec.decompress(packed.data(), packed.size() - 1, restored) == false);
+				packed.push_back(0);
+				REQUIRE(codec.decompress(packed.data(), packed.size(), restored) == false);
+			}
+		}
+
+		WHEN("A large buffer is compressed") {
+			vector<unsigned char> data;
+			for(int i = 0; i < 100000; i++) {
+				data.push_back(i % 9 == 0 ? rand() % 256 : 'a' + rand() % 6);
+			}
+			vector<unsigned char> packed = codec.compress(data.data(), data.size());
+
+			THEN("It shrinks and decompresses back") {
+				REQUIRE(packed.size() < data.size());
+				vector<unsigned char> restored;
+				REQUIRE(codec.decompress(packed.data(), packed.size(), restored) == true);
+				REQUIRE(restored == data);
+			}
+		}
+
+		WHEN("An empty buffer is compressed") {
+			vector<unsigned char> packed = codec.compress(nullptr, 0);
+
+			THEN("It decompresses to nothing") {
+				vector<unsigned char> restored(3, 'x');
+				REQUIRE(codec.decompress(packed.data(), packed.size(), restored) == true);
+				REQUIRE(restored.empty());
+			}
+		}
+
+		WHEN("A single repeated byte is compressed") {
+			vector<unsigned char> data(1000, 'z');
+			vector<unsigned char> packed = codec.compress(data.data(), data.size());
+
+			THEN("It decompresses back") {
+				vector<unsigned char> restored;
+				REQUIRE(codec.decompress(packed.data(), packed.size(), restored) == true);
+				REQUIRE(restored == data);
+			}
+		}
+	}
+}
+
+SCENARIO("A codec is reused across messages", "[HuffmanCodec]") {
+	GIVEN("A codec and output buffers that have held a large message") {
+		HuffmanCodec codec;
+		vector<unsigned char> packed, restored;
+		vector<unsigned char> large(5000, 'q');
+		codec.compress(large.data(), large.size(), packed);
+		codec.decompress(packed.data(), packed.size(), restored);
+		const unsigned char* packed_memory = packed.data();
+		const unsigned char* restored_memory = restored.data();
+
+		WHEN("Smaller messages go through it after a reset") {
+			bool all_match = true;
+			for(int m = 0; m < 50; m++) {
+				string message = "message " + to_string(m * 7919) + " for the codec";
+				codec.reset();
+				codec.compress((const unsigned char*)message.data(), message.size(), packed);
+				REQUIRE(codec.decompress(packed.data(), packed.size(), restored) == true);
+				all_match = all_match && string(restored.begin(), restored.end()) == message;
+			}
+
+			THEN("Each round trips in the same output memory") {
+				REQUIRE(all_match == true);
+				REQUIRE(packed.data() == packed_memory);
+				REQUIRE(restored.data() == restored_memory);
+			}
+		}
+	}
+}
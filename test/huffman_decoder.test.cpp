@@ -0,0 +1,280 @@
+// Test class to test the table-driven Huffman decoder
+
+#include "huffmandecoder.h"
+#include "huffmanbits.h"
+#include <cstdint>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "catch.hpp"
+
+using namespace std;
+using namespace YNGMAT005;
+
+// pack a string of '0'/'1' characters MSB first
+static vector<unsigned char> pack_string(string bits) {
+	vector<unsigned char> bytes((bits.size() + 7) / 8, 0);
+	for(size_t i = 0; i < bits.size(); i++) {
+		if(bits[i] == '1') {
+			bytes[i / 8] |= 1 << (7 - i % 8);
+		}
+	}
+	return bytes;
+}
+
+SCENARIO("The bit reader returns bits most significant first", "[BitReader]") {
+	GIVEN("A reader over two bytes") {
+		unsigned char data[] = { 0xA5, 0x0F };
+		BitReader reader(data, 2);
+		reader.refill();
+
+		THEN("Peeking and consuming walks the stream in order") {
+			REQUIRE(reader.peek(4) == 0xA);
+			reader.consume(4);
+			REQUIRE(reader.peek(8) == 0x50);
+			REQUIRE(reader.peek(4, 4) == 0x0);
+			reader.consume(8);
+			REQUIRE(reader.peek(4) == 0xF);
+			REQUIRE(reader.consumed() == 12);
+		}
+	}
+}
+
+SCENARIO("The bit writer packs whole codes most significant first", "[BitWriter]") {
+	GIVEN("A writer over a buffer larger than a word") {
+		vector<unsigned char> bytes(16, 0xFF);
+		BitWriter writer(bytes.data(), bytes.size());
+
+		WHEN("Codes of mixed lengths are written and flushed") {
+			writer.write(0x5, 3);
+			writer.write(0x0, 2);
+			writer.write(0x3FF, 10);
+			writer.write(0x1, 1);
+			writer.flush();
+
+			THEN("The bytes hold the codes back to back with zero padding") {
+				REQUIRE(writer.written() == 16);
+				REQUIRE(bytes[0] == 0xA7);
+				REQUIRE(bytes[1] == 0xFF);
+			}
+		}
+
+		WHEN("Long codes are written near the end of the buffer") {
+			vector<unsigned char> small(3, 0);
+			BitWriter tail(small.data(), small.size());
+			tail.write(0x1FFFF, 17);
+			tail.write(0x0, 3);
+			tail.flush();
+
+			THEN("The reader recovers them") {
+				BitReader reader(small.data(), small.size());
+				reader.refill();
+				REQUIRE(reader.peek(17) == 0x1FFFF);
+				reader.consume(17);
+				REQUIRE(reader.peek(7) == 0);
+			}
+		}
+	}
+}
+
+SCENARIO("Varints round trip", "[HuffmanBits]") {
+	GIVEN("Values of several sizes") {
+		uint64_t values[] = { 0, 1, 127, 128, 300, uint64_t(1) << 40, ~uint64_t(0) };
+
+		THEN("Each reads back from exactly the bytes written") {
+			for(auto value : values) {
+				vector<unsigned char> bytes;
+				put_varint(bytes, value);
+				uint64_t read = 0;
+				size_t used = 0;
+				REQUIRE(get_varint(bytes.data(), bytes.size(), read, used) == true);
+				REQUIRE(read == value);
+				REQUIRE(used == bytes.size());
+				REQUIRE(get_varint(bytes.data(), bytes.size() - 1, read, used) == false);
+			}
+		}
+	}
+}
+
+SCENARIO("Sizes are checked against the bits that hold them", "[HuffmanBits]") {
+	GIVEN("Symbol counts and bit or byte counts") {
+		THEN("Exact bit counts must give each symbol 1 to MAX_CODE_LENGTH bits") {
+			REQUIRE(fits_code_lengths(10, 10) == true);
+			REQUIRE(fits_code_lengths(10, 10 * MAX_CODE_LENGTH) == true);
+			REQUIRE(fits_code_lengths(10, 9) == false);
+			REQUIRE(fits_code_lengths(10, 10 * MAX_CODE_LENGTH + 1) == false);
+			REQUIRE(fits_code_lengths(0, 0) == true);
+		}
+
+		THEN("Padded byte counts allow any bit count the last byte could end on") {
+			REQUIRE(fits_packed_bytes(0, 0) == true);
+			REQUIRE(fits_packed_bytes(1, 1) == true);
+			REQUIRE(fits_packed_bytes(8, 1) == true);
+			REQUIRE(fits_packed_bytes(9, 1) == false);
+			REQUIRE(fits_packed_bytes(1, 7) == true);
+			REQUIRE(fits_packed_bytes(1, 8) == false);
+			REQUIRE(fits_packed_bytes(0, 1) == false);
+			REQUIRE(fits_packed_bytes(1, uint64_t(1) << 60) == false);
+		}
+	}
+}
+
+SCENARIO("The decoder resolves short codes from the primary table", "[HuffmanDecoder]") {
+	GIVEN("The code a:0 b:10 c:11") {
+		uint64_t codes[256] = {0};
+		unsigned char lengths[256] = {0};
+		codes['a'] = 0; lengths['a'] = 1;
+		codes['b'] = 2; lengths['b'] = 2;
+		codes['c'] = 3; lengths['c'] = 2;
+		HuffmanDecoder decoder;
+		REQUIRE(decoder.build(codes, lengths, 256) == true);
+
+		THEN("A packed message decodes back to its letters") {
+			string bits = "0101100";
+			vector<unsigned char> bytes = pack_string(bits);
+			BitReader reader(bytes.data(), bytes.size());
+			string decoded;
+			REQUIRE(decoder.decode(reader, bits.size(), decoded) == true);
+			REQUIRE(decoded == "abcaa");
+		}
+
+		THEN("A code cut off by the end of the stream is rejected") {
+			string bits = "01";
+			vector<unsigned char> bytes = pack_string(bits);
+			BitReader reader(bytes.data(), bytes.size());
+			string decoded;
+			REQUIRE(decoder.decode(reader, bits.size(), decoded) == false);
+		}
+	}
+}
+
+SCENARIO("The decoder follows subtables for codes longer than the primary table", "[HuffmanDecoder]") {
+	GIVEN("A skewed code with lengths 1 to 30") {
+		// letter i gets the code 1...10 of length i+1, and the last letter 1...11
+		uint64_t codes[256] = {0};
+		unsigned char lengths[256] = {0};
+		string message, bits;
+		for(int i = 0; i < 30; i++) {
+			unsigned char letter = 'A' + i;
+			lengths[letter] = i + 1;
+			codes[letter] = i == 29 ? (uint64_t(1) << 30) - 1 : ((uint64_t(1) << (i + 1)) - 2);
+		}
+		HuffmanDecoder decoder;
+		REQUIRE(decoder.build(codes, lengths, 256) == true);
+		REQUIRE(decoder.table_size() > (size_t(1) << DECODE_TABLE_BITS));
+
+		THEN("Every letter decodes, including ones behind several subtables") {
+			for(int i = 29; i >= 0; i--) {
+				unsigned char letter = 'A' + i;
+				message += letter;
+				for(int b = lengths[letter] - 1; b >= 0; b--) {
+					bits += (codes[letter] >> b) & 1 ? "1" : "0";
+				}
+			}
+			vector<unsigned char> bytes = pack_string(bits);
+			BitReader reader(bytes.data(), bytes.size());
+			string decoded;
+			REQUIRE(decoder.decode(reader, bits.size(), decoded) == true);
+			REQUIRE(decoded == message);
+		}
+	}
+}
+
+SCENARIO("The decoder rejects tables that are not prefix codes", "[HuffmanDecoder]") {
+	GIVEN("Two letters sharing a code") {
+		uint64_t codes[256] = {0};
+		unsigned char lengths[256] = {0};
+		codes['a'] = 1; lengths['a'] = 2;
+		codes['b'] = 1; lengths['b'] = 2;
+		HuffmanDecoder decoder;
+
+		THEN("Building the tables fails") {
+			REQUIRE(decoder.build(codes, lengths, 256) == false);
+			REQUIRE(decoder.is_built() == false);
+		}
+	}
+}
+
+SCENARIO("The decoder streams from and to standard streams", "[HuffmanDecoder]") {
+	GIVEN("A message much longer than one stream chunk") {
+		uint64_t codes[256] = {0};
+		unsigned char lengths[256] = {0};
+		codes['a'] = 0; lengths['a'] = 1;
+		codes['b'] = 2; lengths['b'] = 2;
+		codes['c'] = 3; lengths['c'] = 2;
+		HuffmanDecoder decoder;
+		decoder.build(codes, lengths, 256);
+
+		string message;
+		for(size_t i = 0; i < 3 * STREAM_CHUNK_SIZE; i++) {
+			message += "abc"[rand() % 3];
+		}
+		vector<unsigned char> bytes(message.size(), 0);
+		BitWriter writer(bytes.data(), bytes.size());
+		for(auto& letter : message) {
+			writer.write(codes[(unsigned char)letter], lengths[(unsigned char)letter]);
+		}
+		uint64_t bit_count = writer.written();
+		writer.flush();
+
+		WHEN("It is decoded from an input stream into an output stream") {
+			istringstream in(string(bytes.begin(), bytes.end()));
+			ostringstream out;
+			BitReader reader(in);
+
+			THEN("The output matches across chunk boundaries") {
+				REQUIRE(decoder.decode(reader, bit_count, out) == true);
+				REQUIRE(out.str() == message);
+			}
+		}
+
+		WHEN("It is decoded into a small buffer") {
+			BitReader reader(bytes.data(), bytes.size());
+			unsigned char buffer[100];
+			size_t written = 0;
+
+			THEN("Decoding stops once the buffer is full") {
+				REQUIRE(decoder.decode(reader, bit_count, buffer, 100, written) == true);
+				REQUIRE(written == 100);
+				REQUIRE(string((char*)buffer, 100) == message.substr(0, 100));
+			}
+		}
+	}
+}
+
+SCENARIO("The decoder takes symbols from interleaved streams in turn", "[HuffmanDecoder]") {
+	GIVEN("The code a:0 b:10 c:11 and the message abcaab split over four streams") {
+		uint64_t codes[256] = {0};
+		unsigned char lengths[256] = {0};
+		codes['a'] = 0; lengths['a'] = 1;
+		codes['b'] = 2; lengths['b'] = 2;
+		codes['c'] = 3; lengths['c'] = 2;
+		HuffmanDecoder decoder;
+		decoder.build(codes, lengths, 256);
+
+		// symbols 0 and 4 in stream 0, 1 and 5 in stream 1, and so on
+		vector<unsigned char> s0 = pack_string("00"), s1 = pack_string("1010"), s2 = pack_string("11"), s3 = pack_string("0");
+		vector<BitReader> readers;
+		readers.push_back(BitReader(s0.data(), s0.size()));
+		readers.push_back(BitReader(s1.data(), s1.size()));
+		readers.push_back(BitReader(s2.data(), s2.size()));
+		readers.push_back(BitReader(s3.data(), s3.size()));
+
+		THEN("The symbols come back in their original order") {
+			uint64_t bit_counts[] = { 2, 4, 2, 1 };
+			unsigned char out[6];
+			REQUIRE(decoder.decode_interleaved(readers.data(), bit_counts, out, 6) == true);
+			REQUIRE(string((const char*)out, 6) == "abcaab");
+			REQUIRE(readers[0].consumed() == 2);
+			REQUIRE(readers[1].consumed() == 4);
+			REQUIRE(readers[3].consumed() == 1);
+		}
+
+		THEN("A stream running out of bits stops the decode") {
+			uint64_t bit_counts[] = { 2, 3, 2, 1 };
+			unsigned char out[6];
+			REQUIRE(decoder.decode_interleaved(readers.data(), bit_counts, out, 6) == false);
+		}
+	}
+}
@@ -0,0 +1,77 @@
+// Test class to test the compressed file header
+
+#include "huffmanfile.h"
+#include <cstdint>
+#include <vector>
+#include "catch.hpp"
+
+using namespace std;
+using namespace YNGMAT005;
+
+SCENARIO("The fixed header describes the whole file", "[FileHeader]") {
+	GIVEN("A header for 100 letters in 250 bits with a 7 byte code table") {
+		FileHeader header = { 100, 250, 7 };
+		vector<unsigned char> file;
+		write_file_header(file, header);
+
+		THEN("It takes a fixed number of bytes") {
+			REQUIRE(file.size() == FILE_HEADER_SIZE);
+		}
+
+		WHEN("The table and packed bits follow it") {
+			file.resize(FILE_HEADER_SIZE + 7 + 32);
+
+			THEN("It reads back with every field") {
+				FileHeader read;
+				REQUIRE(read_file_header(file.data(), file.size(), read) == true);
+				REQUIRE(read.raw_size == 100);
+				REQUIRE(read.bit_count == 250);
+				REQUIRE(read.table_size == 7);
+			}
+
+			THEN("A truncated or padded file is rejected") {
+				FileHeader read;
+				REQUIRE(read_file_header(file.data(), file.size() - 1, read) == false);
+				file.push_back(0);
+				REQUIRE(read_file_header(file.data(), file.size(), read) == false);
+			}
+
+			THEN("A file of another format or version is rejected") {
+				FileHeader read;
+				vector<unsigned char> other = file;
+				other[0] = 'X';
+				REQUIRE(read_file_header(other.data(), other.size(), read) == false);
+				other = file;
+				other[4]++;
+				REQUIRE(read_file_header(other.data(), other.size(), read) == false);
+			}
+		}
+	}
+
+	GIVEN("A header for a file far past 4 GiB") {
+		uint64_t raw_size = uint64_t(6) << 32;
+		FileHeader header = { raw_size, 5 * raw_size + 3, 9 };
+		vector<unsigned char> fields;
+		write_file_header(fields, header);
+
+		THEN("The sizes keep all 64 bits") {
+			FileHeader read;
+			uint64_t file_size = FILE_HEADER_SIZE + 9 + header.bit_count / 8 + 1;
+			REQUIRE(read_file_header(fields.data(), file_size, read) == true);
+			REQUIRE(read.raw_size == raw_size);
+			REQUIRE(read.bit_count == header.bit_count);
+		}
+	}
+
+	GIVEN("Sizes no code lengths could give") {
+		FileHeader header = { 10, 9, 3 };
+		vector<unsigned char> file;
+		write_file_header(file, header);
+		file.resize(FILE_HEADER_SIZE + 3 + 2);
+
+		THEN("The header is rejected") {
+			FileHeader read;
+			REQUIRE(read_file_header(file.data(), file.size(), read) == false);
+		}
+	}
+}
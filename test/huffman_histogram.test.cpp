@@ -0,0 +1,118 @@
+// Test class to test the byte histogram kernel
+
+#include "huffmanhistogram.h"
+#include "huffmanthreadpool.h"
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include "catch.hpp"
+
+using namespace std;
+using namespace YNGMAT005;
+
+SCENARIO("Byte counts match a simple loop", "[Histogram]") {
+	GIVEN("Random bytes of a length that isn't a multiple of the word size") {
+		vector<unsigned char> data(100003);
+		for(auto& byte : data) {
+			byte = rand() % 7 == 0 ? 'e' : rand() % 256;
+		}
+
+		WHEN("The bytes are counted from an unaligned start") {
+			uint64_t histogram[256] = {0};
+			count_bytes(data.data() + 1, data.size() - 1, histogram);
+
+			THEN("Every byte value has the same count as counting one by one") {
+				uint64_t expected[256] = {0};
+				for(size_t i = 1; i < data.size(); i++) {
+					expected[data[i]]++;
+				}
+				for(int b = 0; b < 256; b++) {
+					REQUIRE(histogram[b] == expected[b]);
+				}
+			}
+		}
+
+		WHEN("The same bytes are counted twice") {
+			uint64_t histogram[256] = {0};
+			count_bytes(data.data(), data.size(), histogram);
+			count_bytes(data.data(), data.size(), histogram);
+
+			THEN("The counts accumulate") {
+				uint64_t total = 0;
+				for(int b = 0; b < 256; b++) {
+					total += histogram[b];
+				}
+				REQUIRE(total == 2 * data.size());
+			}
+		}
+	}
+}
+
+SCENARIO("Counting in parallel gives the same counts", "[Histogram]") {
+	GIVEN("Several megabytes of random bytes and a pool of threads") {
+		vector<unsigned char> data(5 * PARALLEL_SLICE_SIZE + 12345);
+		for(auto& byte : data) {
+			byte = rand() % 256;
+		}
+		ThreadPool pool(4);
+
+		WHEN("The bytes are counted on the pool") {
+			uint64_t parallel[256] = {0};
+			count_bytes(data.data(), data.size(), parallel, pool);
+
+			THEN("The reduced table matches a single-threaded count") {
+				uint64_t serial[256] = {0};
+				count_bytes(data.data(), data.size(), serial);
+				for(int b = 0; b < 256; b++) {
+					REQUIRE(parallel[b] == serial[b]);
+				}
+			}
+		}
+
+		WHEN("The input is smaller than a slice") {
+			uint64_t parallel[256] = {0};
+			count_bytes(data.data(), 1000, parallel, pool);
+
+			THEN("It is still counted") {
+				uint64_t total = 0;
+				for(int b = 0; b < 256; b++) {
+					total += parallel[b];
+				}
+				REQUIRE(total == 1000);
+			}
+		}
+	}
+}
+
+SCENARIO("Large inputs can be sampled", "[Histogram]") {
+	GIVEN("An input of a hundred sample blocks") {
+		vector<unsigned char> data(100 * SAMPLE_BLOCK_SIZE);
+		for(size_t i = 0; i < data.size(); i++) {
+			data[i] = i % 3 == 0 ? 'x' : 'a' + rand() % 4;
+		}
+
+		WHEN("A twentieth of it is sampled") {
+			uint64_t histogram[256] = {0};
+			size_t counted = sample_bytes(data.data(), data.size(), histogram, 0.05);
+
+			THEN("Five blocks are counted, keeping the input's proportions") {
+				REQUIRE(counted == 5 * SAMPLE_BLOCK_SIZE);
+				uint64_t total = 0;
+				for(int b = 0; b < 256; b++) {
+					total += histogram[b];
+				}
+				REQUIRE(total == counted);
+				REQUIRE(histogram['x'] > counted / 3 - 10);
+				REQUIRE(histogram['x'] < counted / 3 + 10);
+			}
+		}
+
+		WHEN("Most of it would be sampled anyway") {
+			uint64_t histogram[256] = {0};
+
+			THEN("All of it is counted") {
+				REQUIRE(sample_bytes(data.data(), data.size(), histogram, 0.6) == data.size());
+			}
+		}
+	}
+}
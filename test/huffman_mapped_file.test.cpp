@@ -0,0 +1,69 @@
+// Test class to test mapped file input
+
+#include "huffmanmappedfile.h"
+#include <fstream>
+#include <iterator>
+#include <string>
+#include "catch.hpp"
+
+using namespace std;
+using namespace YNGMAT005;
+
+SCENARIO("Files are mapped whole", "[MappedFile]") {
+	GIVEN("A text file") {
+		ifstream in("Test Files/long_text.txt", ios::binary);
+		string data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+		MappedFile file;
+
+		WHEN("It is opened") {
+			REQUIRE(file.open("Test Files/long_text.txt", true) == true);
+
+			THEN("Its bytes are mapped, not copied") {
+				REQUIRE(file.is_open() == true);
+				REQUIRE(file.is_mapped() == true);
+				REQUIRE(file.size() == data.size());
+				REQUIRE(string((const char*)file.data(), file.size()) == data);
+			}
+
+			THEN("Released pages are read in again when touched") {
+				file.release(0, file.size() / 2);
+				file.release(file.size() / 2, file.size());
+				REQUIRE(file.is_mapped() == true);
+				REQUIRE(string((const char*)file.data(), file.size()) == data);
+			}
+
+			THEN("Detaching it keeps a copy of the bytes") {
+				file.detach();
+				REQUIRE(file.is_mapped() == false);
+				REQUIRE(string((const char*)file.data(), file.size()) == data);
+			}
+
+			THEN("Closing it releases the mapping") {
+				file.close();
+				REQUIRE(file.is_open() == false);
+				REQUIRE(file.size() == 0);
+			}
+		}
+	}
+
+	GIVEN("Files that can't be mapped") {
+		MappedFile file;
+
+		THEN("An empty file opens with no bytes") {
+			REQUIRE(file.open("Test Files/empty.txt", true) == true);
+			REQUIRE(file.is_mapped() == false);
+			REQUIRE(file.size() == 0);
+		}
+
+		THEN("A device is read in instead") {
+			REQUIRE(file.open("/dev/null", false) == true);
+			REQUIRE(file.is_mapped() == false);
+			REQUIRE(file.size() == 0);
+		}
+
+		THEN("A missing file fails to open") {
+			REQUIRE(file.open("Test Files/no_such_file.txt", true) == false);
+			REQUIRE(file.is_open() == false);
+		}
+	}
+}
@@ -0,0 +1,94 @@
+// Test class to test the bounded lock-free queue
+
+#include "huffmanqueue.h"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "catch.hpp"
+
+using namespace std;
+using namespace YNGMAT005;
+
+SCENARIO("Values leave the queue in the order they went in", "[BoundedQueue]") {
+	GIVEN("A queue with room for three values") {
+		BoundedQueue<int> queue(3);
+
+		WHEN("It is empty") {
+			THEN("Nothing can be popped") {
+				int value = 0;
+				REQUIRE(queue.try_pop(value) == false);
+			}
+		}
+
+		WHEN("It is filled to its rounded up capacity") {
+			for(int i = 0; i < 4; i++) {
+				REQUIRE(queue.try_push(i) == true);
+			}
+
+			THEN("Another push is refused until a value is popped") {
+				int value = 4;
+				REQUIRE(queue.try_push(value) == false);
+				int first = -1;
+				REQUIRE(queue.try_pop(first) == true);
+				REQUIRE(first == 0);
+				REQUIRE(queue.try_push(value) == true);
+			}
+
+			THEN("The values come back first in, first out") {
+				for(int i = 0; i < 4; i++) {
+					int value = -1;
+					REQUIRE(queue.try_pop(value) == true);
+					REQUIRE(value == i);
+				}
+				int value = 0;
+				REQUIRE(queue.try_pop(value) == false);
+			}
+		}
+	}
+}
+
+SCENARIO("Several threads share a queue", "[BoundedQueue]") {
+	GIVEN("Two producers and two consumers") {
+		BoundedQueue<uint64_t> queue(8);
+		const uint64_t per_producer = 100000;
+		atomic<uint64_t> popped(0), total(0);
+
+		WHEN("Each producer pushes its own numbers") {
+			vector<thread> threads;
+			for(uint64_t p = 0; p < 2; p++) {
+				threads.push_back(thread([&, p]() {
+					for(uint64_t i = 1; i <= per_producer; i++) {
+						uint64_t value = p * per_producer + i;
+						while(!queue.try_push(value)) {
+							this_thread::yield();
+						}
+					}
+				}));
+			}
+			for(int c = 0; c < 2; c++) {
+				threads.push_back(thread([&]() {
+					while(popped.load() < 2 * per_producer) {
+						uint64_t value;
+						if(queue.try_pop(value)) {
+							total += value;
+							popped++;
+						} else {
+							this_thread::yield();
+						}
+					}
+				}));
+			}
+			for(auto& worker : threads) {
+				worker.join();
+			}
+
+			THEN("Every value is popped exactly once") {
+				uint64_t count = 2 * per_producer;
+				uint64_t expected = count * (count + 1) / 2;
+				REQUIRE(popped.load() == count);
+				REQUIRE(total.load() == expected);
+			}
+		}
+	}
+}
@@ -0,0 +1,87 @@
+// Test class to test compression against a shared trained table
+
+#include "huffmansharedcodec.h"
+#include "huffmancodec.h"
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "catch.hpp"
+
+using namespace std;
+using namespace YNGMAT005;
+
+// a small JSON-like request of the kind the table is trained on
+static string make_message(int id) {
+	return "{\"id\":" + to_string(id) + ",\"method\":\"get\",\"path\":\"/users/" + to_string(id * 31 % 1000) + "\"}";
+}
+
+SCENARIO("Messages are compressed against a trained table", "[HuffmanSharedCodec]") {
+	GIVEN("A table trained on sample messages") {
+		HuffmanSharedCodec trainer;
+		for(int i = 0; i < 200; i++) {
+			string sample = make_message(i);
+			trainer.add_sample((const unsigned char*)sample.data(), sample.size());
+		}
+		REQUIRE(trainer.train() == true);
+
+		THEN("Every byte value has a code within the length limit") {
+			REQUIRE(trainer.get_codes().size() == 256);
+			for(int i = 0; i < 256; i++) {
+				REQUIRE(trainer.get_codes().get(i).length <= DEFAULT_SHARED_CODE_LENGTH);
+			}
+		}
+
+		WHEN("The table is serialized and loaded by another codec") {
+			vector<unsigned char> table;
+			trainer.serialize(table);
+			HuffmanSharedCodec receiver;
+			size_t used = 0;
+			REQUIRE(receiver.load(table.data(), table.size(), used) == true);
+			REQUIRE(used == table.size());
+
+			THEN("Messages cross between them with no code lengths attached") {
+				string message = make_message(4242);
+				vector<unsigned char> packed, restored;
+				REQUIRE(trainer.compress((const unsigned char*)message.data(), message.size(), packed) == true);
+				REQUIRE(receiver.decompress(packed.data(), packed.size(), restored) == true);
+				REQUIRE(string(restored.begin(), restored.end()) == message);
+
+				HuffmanCodec per_message;
+				vector<unsigned char> with_header = per_message.compress((const unsigned char*)message.data(), message.size());
+				REQUIRE(packed.size() < with_header.size());
+				REQUIRE(packed.size() < message.size());
+			}
+
+			THEN("Bytes never seen in training still round trip") {
+				string message = "\x01\xFE unseen \x7F";
+				vector<unsigned char> packed, restored;
+				REQUIRE(trainer.compress((const unsigned char*)message.data(), message.size(), packed) == true);
+				REQUIRE(receiver.decompress(packed.data(), packed.size(), restored) == true);
+				REQUIRE(string(restored.begin(), restored.end()) == message);
+			}
+		}
+
+		WHEN("A message is damaged") {
+			string message = make_message(7);
+			vector<unsigned char> packed, restored;
+			trainer.compress((const unsigned char*)message.data(), message.size(), packed);
+
+			THEN("Truncated or padded messages are rejected") {
+				REQUIRE(trainer.decompress(packed.data(), packed.size() - 1, restored) == false);
+				packed.push_back(0);
+				REQUIRE(trainer.decompress(packed.data(), packed.size(), restored) == false);
+			}
+		}
+	}
+
+	GIVEN("A codec with no table") {
+		HuffmanSharedCodec codec;
+		vector<unsigned char> packed;
+
+		THEN("Nothing is compressed") {
+			REQUIRE(codec.is_ready() == false);
+			REQUIRE(codec.compress((const unsigned char*)"abc", 3, packed) == false);
+		}
+	}
+}
@@ -2,12 +2,21 @@
 
 #include "huffmantree.h"
 #include "huffmannode.h"
+#include "huffmanfile.h"
+#include "huffmanmappedfile.h"
+#include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <queue>
 #include <fstream>
+#include <cstdio>
 #include <cstdlib>
+#include <sstream>
+#include <iterator>
+#include <streambuf>
+#include <vector>
 #include "catch.hpp"
 
 using namespace std;
@@ -44,7 +53,7 @@ SCENARIO("The code table is populated correctly") {
 		/*
 		|__:8
 		|  |
-		|  |__a:4
+		|  |__d:4
 		|  |  |__
 		|  |  |__
 		|  |
@@ -58,33 +67,33 @@ SCENARIO("The code table is populated correctly") {
 		   |  |__
 		   |  |__
 		   |
-		   |__d:4
+		   |__a:4
 		      |__
 		      |__
 		      */
 
-		THEN("From the tree above and the rules for building each letter code") {
+		THEN("From the tree above and the rules for building canonical letter codes") {
 			unordered_map<string, string> code_table = test.get_code_table();
-			REQUIRE(code_table["a"] == "11");
-			REQUIRE(code_table["b"] == "00");
-			REQUIRE(code_table["c"] == "01");
-			REQUIRE(code_table["d"] == "10");
+			REQUIRE(code_table["a"] == "00");
+			REQUIRE(code_table["b"] == "01");
+			REQUIRE(code_table["c"] == "10");
+			REQUIRE(code_table["d"] == "11");
 		}
 	}
 
 	GIVEN("A loaded and built Huffman Tree") {
 		HuffmanTree test("Test Files/test4", "test4_out");
 
-		THEN("From the rules for building each letter code") {
+		THEN("From the rules for building canonical letter codes") {
 			unordered_map<string, string> code_table = test.get_code_table();
-			REQUIRE(code_table["r"] == "100");
-			REQUIRE(code_table["v"] == "1110");
-			REQUIRE(code_table["l"] == "00");
-			REQUIRE(code_table["d"] == "101");
+			REQUIRE(code_table["b"] == "000");
+			REQUIRE(code_table["d"] == "001");
 			REQUIRE(code_table["i"] == "010");
-			REQUIRE(code_table["n"] == "1111");
+			REQUIRE(code_table["l"] == "011");
+			REQUIRE(code_table["n"] == "100");
+			REQUIRE(code_table["r"] == "101");
 			REQUIRE(code_table["s"] == "110");
-			REQUIRE(code_table["b"] == "011");
+			REQUIRE(code_table["v"] == "111");
 		}
 	}
 }
@@ -101,7 +110,7 @@ SCENARIO("The frequency table is populated correctly") {
 			test.load_data();
 
 			THEN("The frequency table should be populated") {
-				unordered_map<string, int> table = test.get_frequency_table();
+				unordered_map<string, uint64_t> table = test.get_frequency_table();
 				REQUIRE(table["a"] == 4);
 				REQUIRE(table["b"] == 4);
 				REQUIRE(table["c"] == 4);
@@ -242,6 +251,233 @@ SCENARIO("Bit stream reading and writing works correctly") {
 	}
 }
 
+SCENARIO("The bit stream can be decoded using only the compressed file") {
+	GIVEN("A compressed file written by another tree") {
+		HuffmanTree encoder("Test Files/test4", "test4_out");
+		encoder.write_bits();
+
+		WHEN("A fresh tree reads the bit stream") {
+			HuffmanTree decoder;
+			decoder.set_output_file("test4_out");
+
+			THEN("The codes are rebuilt from the code lengths alone") {
+				REQUIRE(decoder.read_bits() == "vlsindrblsdnbilsdr");
+			}
+		}
+
+		WHEN("The compressed file is cut short") {
+			ifstream in("test4_out.huf", ios::binary);
+			string file((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+			in.close();
+			ofstream("test4_cut.huf", ios::binary) << file.substr(0, file.size() - 1);
+			HuffmanTree decoder;
+			decoder.set_output_file("test4_cut");
+
+			THEN("Its header no longer matches and it is rejected") {
+				ostringstream out;
+				REQUIRE(decoder.read_bits(out) == false);
+				REQUIRE(decoder.read_bits() == "");
+			}
+		}
+
+		WHEN("The letter count in its header no longer matches the bits") {
+			ifstream in("test4_out.huf", ios::binary);
+			string file((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+			in.close();
+			// the raw size is the 8 byte field after the code table size
+			file[8]--;
+			ofstream("test4_miscounted.huf", ios::binary) << file;
+			HuffmanTree decoder;
+			decoder.set_output_file("test4_miscounted");
+
+			THEN("The decoded letters are rejected") {
+				ostringstream out;
+				REQUIRE(decoder.read_bits(out) == false);
+				REQUIRE(decoder.read_bits() == "");
+			}
+		}
+	}
+}
+
+SCENARIO("Code lengths can be limited") {
+	GIVEN("A file with doubling letter frequencies") {
+		ofstream skewed("skewed_chars.txt");
+		string data;
+		for(int i = 0; i < 12; i++) {
+			data += string(1 << i, 'a' + i);
+		}
+		skewed << data;
+		skewed.close();
+
+		WHEN("The tree is built with a 6 bit limit") {
+			HuffmanTree tree;
+			tree.set_input_file("skewed_chars");
+			tree.set_output_file("skewed_chars");
+			tree.set_max_code_length(6);
+			tree.run();
+			tree.write_bits();
+
+			THEN("No code is longer than the limit") {
+				for(auto& code : tree.get_code_table()) {
+					REQUIRE(code.second.size() <= 6);
+				}
+			}
+
+			THEN("The data still round trips") {
+				REQUIRE(tree.read_bits() == data);
+			}
+		}
+	}
+}
+
+SCENARIO("Binary files and line breaks are compressed byte for byte") {
+	GIVEN("A file with line breaks and every byte value") {
+		ofstream binary("binary_chars.txt", ios::binary);
+		string data = "first line\nsecond line\r\n";
+		for(int i = 0; i < 256; i++) {
+			data += char(i);
+		}
+		binary << data;
+		binary.close();
+
+		WHEN("The file is loaded") {
+			HuffmanTree tree("binary_chars", "binary_chars");
+
+			THEN("Every byte is counted, including line breaks") {
+				unordered_map<string, uint64_t> table = tree.get_frequency_table();
+				REQUIRE(table["\n"] == 3);
+				REQUIRE(table["\r"] == 2);
+				REQUIRE(table[string(1, '\0')] == 1);
+				REQUIRE(table.size() == 256);
+			}
+
+			THEN("The bit stream decodes to the exact bytes") {
+				tree.write_bits();
+				REQUIRE(tree.read_bits() == data);
+			}
+		}
+	}
+}
+
+SCENARIO("The bit stream can be decoded into an output stream") {
+	GIVEN("A compressed long text") {
+		HuffmanTree tree("Test Files/long_text", "long_text_out");
+		tree.write_bits();
+
+		THEN("Streaming the decoded bytes gives the original file") {
+			ifstream in("Test Files/long_text.txt", ios::binary);
+			string data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+			ostringstream out;
+			REQUIRE(tree.read_bits(out) == true);
+			REQUIRE(out.str() == data);
+		}
+	}
+}
+
+SCENARIO("Files can be compressed in chunks") {
+	GIVEN("A file spanning several read chunks") {
+		ofstream big("chunked_chars.txt", ios::binary);
+		string data;
+		for(size_t i = 0; i < 2 * READ_BLOCK_SIZE + 999; i++) {
+			data += char(rand() % 2 == 0 ? 'x' : rand() % 256);
+		}
+		big << data;
+		big.close();
+
+		WHEN("It is compressed with the streaming encoder") {
+			HuffmanTree tree;
+			tree.set_input_file("chunked_chars");
+			tree.set_output_file("chunked_chars");
+			REQUIRE(tree.stream_bits() == true);
+
+			THEN("The bit stream matches the in-memory encoder") {
+				ifstream streamed_file("chunked_chars.huf", ios::binary);
+				string streamed((istreambuf_iterator<char>(streamed_file)), istreambuf_iterator<char>());
+				HuffmanTree memory("chunked_chars", "chunked_memory");
+				memory.write_bits();
+				ifstream memory_file("chunked_memory.huf", ios::binary);
+				string in_memory((istreambuf_iterator<char>(memory_file)), istreambuf_iterator<char>());
+				REQUIRE(streamed == in_memory);
+			}
+
+			THEN("It decodes back to the original file") {
+				REQUIRE(tree.read_bits() == data);
+			}
+		}
+
+		WHEN("The input file doesn't exist") {
+			HuffmanTree tree;
+			tree.set_input_file("no_such_file");
+			tree.set_output_file("no_such_file");
+
+			THEN("Nothing is compressed") {
+				REQUIRE(tree.stream_bits() == false);
+				REQUIRE(tree.has_loaded() == false);
+			}
+		}
+	}
+}
+
+SCENARIO("The tree can be built from a sample of a large file") {
+	GIVEN("A file much larger than the sample") {
+		string data;
+		for(int i = 0; i < (1 << 22); i++) {
+			data += char(i % 100000 == 0 ? '~' : 'a' + rand() % (i < (1 << 21) ? 6 : 12));
+		}
+		ofstream("sampled_input.txt", ios::binary) << data;
+
+		WHEN("It is streamed from a 2% sample") {
+			HuffmanTree tree;
+			tree.set_input_file("sampled_input");
+			tree.set_output_file("sampled_input_out");
+			tree.set_sample_fraction(0.02);
+			REQUIRE(tree.stream_bits() == true);
+
+			THEN("Only the sample is counted, yet every byte decodes") {
+				uint64_t counted = 0;
+				for(auto& frequency : tree.get_frequency_table()) {
+					counted += frequency.second;
+				}
+				REQUIRE(counted < data.size() / 10);
+				REQUIRE(tree.get_code_table().size() == 256);
+				ostringstream out;
+				REQUIRE(tree.read_bits(out) == true);
+				REQUIRE(out.str() == data);
+			}
+		}
+	}
+}
+
+SCENARIO("Files can be compressed into independent blocks") {
+	GIVEN("A tree set to use several threads") {
+		HuffmanTree tree;
+		tree.set_input_file("Test Files/long_text");
+		tree.set_output_file("long_text_blocks");
+		tree.set_threads(3);
+
+		WHEN("The file is compressed in small blocks") {
+			REQUIRE(tree.write_blocks(100) == true);
+
+			THEN("Reading the blocks gives the original file") {
+				ifstream in("Test Files/long_text.txt", ios::binary);
+				string data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+				ostringstream out;
+				REQUIRE(tree.read_blocks(out) == true);
+				REQUIRE(out.str() == data);
+			}
+
+			THEN("A range spanning blocks can be read on its own") {
+				ifstream in("Test Files/long_text.txt", ios::binary);
+				string data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+				string range;
+				REQUIRE(tree.read_range(150, 120, range) == true);
+				REQUIRE(range == data.substr(150, 120));
+				REQUIRE(tree.read_range(0, data.size() + 1, range) == false);
+			}
+		}
+	}
+}
+
 SCENARIO("The Huffman Tree can decode a binary message to an ASCII message") {
 	GIVEN("A correctly loaded and built HuffmanTree and its code table") {
 		HuffmanTree tree("Test Files/test3", "test3_out");
@@ -281,12 +517,18 @@ SCENARIO("Assignment operators and constructors/destructor works properly") {
 				REQUIRE(tree2.get_frequency_table() == tree.get_frequency_table());
 				REQUIRE(tree2.get_code_table() == tree.get_code_table());
 			}
+
+			THEN("The copy compresses the same input") {
+				tree2.set_output_file("test3_copy");
+				tree2.write_bits();
+				REQUIRE(tree2.read_bits() == "aaaabbbbccccdddd");
+			}
 		}
 
 		WHEN("The first tree is moved by constructor to the second tree") {
 			shared_ptr<HuffmanNode> tree_root = tree.get_root();
 			unordered_map<string, string> codes = tree.get_code_table();
-			unordered_map<string, int> frequencies = tree.get_frequency_table();
+			unordered_map<string, uint64_t> frequencies = tree.get_frequency_table();
 			HuffmanTree tree2(move(tree));
 
 			THEN("The first tree's resources should be in the second") {
@@ -301,7 +543,7 @@ SCENARIO("Assignment operators and constructors/destructor works properly") {
 			HuffmanTree tree2("Test Files/test3", "test3_out");
 			shared_ptr<HuffmanNode> tree_root = tree2.get_root();
 			unordered_map<string, string> codes = tree2.get_code_table();
-			unordered_map<string, int> frequencies = tree2.get_frequency_table();
+			unordered_map<string, uint64_t> frequencies = tree2.get_frequency_table();
 			HuffmanTree tree3 = move(tree2);
 
 			THEN("The first tree's resources should be in the second") {
@@ -312,4 +554,118 @@ SCENARIO("Assignment operators and constructors/destructor works properly") {
 			}
 		}
 	}
-}
\ No newline at end of file
+}
+
+// Skewed pseudo-random bytes, the same for every generator started from the same seed
+class SyntheticData {
+	private:
+		uint64_t state;
+
+	public:
+		SyntheticData(uint64_t seed) : state(seed) {}
+
+		unsigned char next(void) {
+			state ^= state << 13;
+			state ^= state >> 7;
+			state ^= state << 17;
+			// a quarter of the bytes from the whole range, the rest from 16 letters
+			return (unsigned char)(state & 3 ? 'a' + (state >> 40) % 16 : state >> 56);
+		}
+};
+
+// Output stream buffer checking every byte written to it against a generator
+class SyntheticCheck : public streambuf {
+	private:
+		SyntheticData expected;
+		uint64_t count;
+		bool matching;
+
+	protected:
+		int overflow(int c) override {
+			if(c != EOF) {
+				char byte = char(c);
+				this->xsputn(&byte, 1);
+			}
+			return c;
+		}
+
+		streamsize xsputn(const char* data, streamsize size) override {
+			for(streamsize i = 0; i < size; i++) {
+				matching = matching && (unsigned char)data[i] == expected.next();
+			}
+			count += size;
+			return size;
+		}
+
+	public:
+		SyntheticCheck(uint64_t seed) : expected(seed), count(0), matching(true) {}
+
+		// true if exactly 'size' bytes were written and all matched
+		bool matches(uint64_t size) const {
+			return matching && count == size;
+		}
+};
+
+// write 'size' generated bytes to 'file' a chunk at a time
+void write_synthetic(string file, uint64_t seed, uint64_t size) {
+	ofstream out(file, ios::binary);
+	SyntheticData generator(seed);
+	vector<char> chunk(READ_BLOCK_SIZE);
+	for(uint64_t written = 0; written < size; written += chunk.size()) {
+		chunk.resize(min(uint64_t(READ_BLOCK_SIZE), size - written));
+		for(auto& byte : chunk) {
+			byte = char(generator.next());
+		}
+		out.write(chunk.data(), chunk.size());
+	}
+}
+
+// Hidden: run with "[large]" to check sizes past 32 bits
+SCENARIO("Files whose compressed bit count passes 32 bits round trip", "[.][large]") {
+	GIVEN("A generated 1 GiB file") {
+		uint64_t size = uint64_t(1) << 30;
+		write_synthetic("large_input.txt", 7, size);
+
+		WHEN("It is streamed to a compressed file") {
+			HuffmanTree tree;
+			tree.set_input_file("large_input");
+			tree.set_output_file("large_streamed");
+			REQUIRE(tree.stream_bits() == true);
+
+			THEN("The header holds the whole bit count and every byte decodes") {
+				MappedFile compressed;
+				FileHeader header;
+				REQUIRE(compressed.open("large_streamed.huf", true) == true);
+				REQUIRE(read_file_header(compressed.data(), compressed.size(), header) == true);
+				REQUIRE(header.raw_size == size);
+				REQUIRE(header.bit_count > (uint64_t(1) << 32));
+				SyntheticCheck check(7);
+				ostream out(&check);
+				REQUIRE(tree.read_bits(out) == true);
+				REQUIRE(check.matches(size) == true);
+			}
+		}
+
+		WHEN("It is compressed in memory") {
+			HuffmanTree tree("large_input", "large_memory");
+			tree.write_bits();
+
+			THEN("It decodes back to the generated bytes") {
+				uint64_t counted = 0;
+				for(auto& frequency : tree.get_frequency_table()) {
+					counted += frequency.second;
+				}
+				REQUIRE(counted == size);
+				SyntheticCheck check(7);
+				ostream out(&check);
+				REQUIRE(tree.read_bits(out) == true);
+				REQUIRE(check.matches(size) == true);
+			}
+		}
+
+		// the generated files take up about 2.5 GB
+		remove("large_input.txt");
+		remove("large_streamed.huf");
+		remove("large_memory.huf");
+	}
+}